@@ -1,4 +1,5 @@
 #include "raylib.h"
+#include "resources.h"
 #include <time.h>
 #include <stdlib.h>
 
@@ -25,27 +26,25 @@ typedef struct {
     int currentPower;    // Modified power after buffs/debuffs
     int isHero;          // Hero cards ignore weather
     int isGold;          // Special status (immune sometimes)
-    Image image;
     Texture2D normTex;
     Texture2D rotatedTex;   // Card artwork
 } Card;
 
-Card CreateCard(CardType type, RowType row, int basePower, Image img, int hero, int gold) {
+Card CreateCard(CardType type, RowType row, int basePower, ResourceHandle img, int hero, int gold) {
     Card c;
     c.type = type;
     c.row = row;
     c.basePower = basePower;
     c.currentPower = basePower;
-    c.image = img;
-    c.normTex = LoadTextureFromImage(c.image);
-    ImageRotateCW(&c.image);
-    c.rotatedTex = LoadTextureFromImage(c.image);
+    c.normTex = ResGetTexture(ResLoadTextureFromImage(img, 0, SCOPE_GLOBAL));
+    c.rotatedTex = ResGetTexture(ResLoadTextureFromImage(img, 1, SCOPE_GLOBAL));
     c.isHero = hero;
     c.isGold = gold;
     return c;
 }
 
-Card GetRandomCard(Card *cards, int totalCards) {
+// Returns an index into cards; callers keep the index, not a copy of the card
+int GetRandomCard(Card *cards, int totalCards) {
     int r = rand() % 100; // random number 0–99
 
     CardType chosenType;
@@ -54,15 +53,11 @@ Card GetRandomCard(Card *cards, int totalCards) {
     else chosenType = CARD_HERO;                 // 10%
 
     // Now select a random card of that type
-    Card selected;
-    int found = 0;
+    int selected = -1;
 
-    while (!found) {
+    while (selected == -1) {
         int idx = rand() % totalCards;
-        if (cards[idx].type == chosenType) {
-            selected = cards[idx];
-            found = 1;
-        }
+        if (cards[idx].type == chosenType) selected = idx;
     }
 
     return selected;
@@ -74,22 +69,23 @@ int main(void) {
     const int screenHeight = 768;
     InitWindow(screenWidth, screenHeight, "GOWTHER");
     SetTargetFPS(60);
+    ResInit(0);
 
     Card cards[12];
 
     // Load Images
-    Image mugSold = LoadImage("mughalSoldier.png");
-    Image boltu = LoadImage("bangabaltu.png");
-    Image claw = LoadImage("clawarchi.png");
-    Image fog = LoadImage("fog.png");
-    Image frost = LoadImage("frostbite.jpg");
-    Image hitler = LoadImage("hitler.png");
-    Image khalid = LoadImage("khalid.png");
-    Image mongarch = LoadImage("mongolArcher.png");
-    Image odyss = LoadImage("odysseus.png");
-    Image storm = LoadImage("storm.png");
-    Image suleiman = LoadImage("suleiman.png");
-    Image trebuchet = LoadImage("trebuchet.png");
+    ResourceHandle mugSold = ResLoadImage("mughalSoldier.png", SCOPE_GLOBAL);
+    ResourceHandle boltu = ResLoadImage("bangabaltu.png", SCOPE_GLOBAL);
+    ResourceHandle claw = ResLoadImage("clawarchi.png", SCOPE_GLOBAL);
+    ResourceHandle fog = ResLoadImage("fog.png", SCOPE_GLOBAL);
+    ResourceHandle frost = ResLoadImage("frostbite.jpg", SCOPE_GLOBAL);
+    ResourceHandle hitler = ResLoadImage("hitler.png", SCOPE_GLOBAL);
+    ResourceHandle khalid = ResLoadImage("khalid.png", SCOPE_GLOBAL);
+    ResourceHandle mongarch = ResLoadImage("mongolArcher.png", SCOPE_GLOBAL);
+    ResourceHandle odyss = ResLoadImage("odysseus.png", SCOPE_GLOBAL);
+    ResourceHandle storm = ResLoadImage("storm.png", SCOPE_GLOBAL);
+    ResourceHandle suleiman = ResLoadImage("suleiman.png", SCOPE_GLOBAL);
+    ResourceHandle trebuchet = ResLoadImage("trebuchet.png", SCOPE_GLOBAL);
 
     // Create Cards
     cards[0] = CreateCard(CARD_NORMAL, ROW_MELEE, 5, mugSold, 0, 0);
@@ -105,10 +101,14 @@ int main(void) {
     cards[10] = CreateCard(CARD_LEADER, ROW_GLOBAL, 0, suleiman, 0, 0);
     cards[11] = CreateCard(CARD_NORMAL, ROW_SIEGE, 8, trebuchet, 0, 0);
 
+    // Textures are uploaded, the CPU copies can go
+    ResourceHandle cardImages[12] = { mugSold, boltu, claw, fog, frost, hitler, khalid, mongarch, odyss, storm, suleiman, trebuchet };
+    for (int i = 0; i < 12; i++) ResRelease(cardImages[i]);
+
     // Load Textures for UI
-    Texture2D menuBG = LoadTexture("main menu.jpg");
-    Texture2D gameBoard = LoadTexture("gameBoard.jpg");
-    Texture2D buttons = LoadTexture("buttons.png");
+    Texture2D menuBG = ResGetTexture(ResLoadTexture("main menu.jpg", SCOPE_GLOBAL));
+    Texture2D gameBoard = ResGetTexture(ResLoadTexture("gameBoard.jpg", SCOPE_GLOBAL));
+    Texture2D buttons = ResGetTexture(ResLoadTexture("buttons.png", SCOPE_GLOBAL));
 
     Rectangle btnPlay = { 200, 320, 200, 89 };
     Rectangle btnQuit = { 200, 390, 200, 89 };
@@ -117,7 +117,7 @@ int main(void) {
     int gameState = MENU;
 
     // Fill cards1 array with random cards
-    Card cards1[1000];
+    int cards1[1000];
     for(int i = 0; i < 1000; i++) {
         cards1[i] = GetRandomCard(cards, 12);
     }
@@ -163,7 +163,7 @@ int main(void) {
             for (int i = 0; i < 1000; i++) {
                 float y = i * CARD_HEIGHT - offsetY;
                 if (y + CARD_HEIGHT > 0 && y < screenHeight) {
-                    DrawTexture(cards1[i].normTex, centerX, y, WHITE);
+                    DrawTexture(cards[cards1[i]].normTex, centerX, y, WHITE);
                 }
             }
         }
@@ -178,6 +178,7 @@ int main(void) {
         EndDrawing();
     }
 
+    ResShutdown();
     CloseWindow();
     return 0;
 }
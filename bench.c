@@ -0,0 +1,214 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+static float frameMs[BENCH_MAX_FRAMES];
+static float cpuMs[BENCH_MAX_FRAMES];
+static int batchCount[BENCH_MAX_FRAMES];
+static int frameCount;
+static double frameStart, cpuStart;
+
+#if defined(_WIN32)
+
+static double WallNow(void)
+{
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart / (double)freq.QuadPart;
+}
+
+static double CpuNow(void)
+{
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    unsigned long long k = ((unsigned long long)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    unsigned long long u = ((unsigned long long)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (double)(k + u) * 1e-7; // 100 ns units
+}
+
+static long PeakRssKb(void)
+{
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return (long)(pmc.PeakWorkingSetSize / 1024);
+}
+
+#else
+
+static double ClockNow(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double WallNow(void)
+{
+    return ClockNow(CLOCK_MONOTONIC);
+}
+
+static double CpuNow(void)
+{
+    return ClockNow(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+static long PeakRssKb(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024; // Bytes there
+#else
+    return ru.ru_maxrss;
+#endif
+}
+
+#endif
+
+void BenchStart(void)
+{
+    frameCount = 0;
+}
+
+void BenchFrameBegin(void)
+{
+    frameStart = WallNow();
+    cpuStart = CpuNow();
+}
+
+void BenchFrameEnd(int batches)
+{
+    if (frameCount >= BENCH_MAX_FRAMES)
+        return;
+    frameMs[frameCount] = (float)((WallNow() - frameStart) * 1000.0);
+    cpuMs[frameCount] = (float)((CpuNow() - cpuStart) * 1000.0);
+    batchCount[frameCount] = batches;
+    frameCount++;
+}
+
+static int CompareFloats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts the samples in place
+static float Percentile(float *samples, int count, float p)
+{
+    if (count <= 0)
+        return 0.0f;
+    qsort(samples, count, sizeof(float), CompareFloats);
+    int i = (int)(p * (count - 1) + 0.5f);
+    return samples[i];
+}
+
+BenchResult BenchFinish(void)
+{
+    BenchResult r = {0};
+    r.frames = frameCount;
+    r.peakRssKb = PeakRssKb();
+
+    int skip = frameCount > BENCH_WARMUP_FRAMES * 2 ? BENCH_WARMUP_FRAMES : 0;
+    int n = frameCount - skip;
+    long long batches = 0;
+    for (int i = skip; i < frameCount; i++)
+        batches += batchCount[i];
+    if (n > 0)
+        r.batchesAvg = (float)((double)batches / n);
+    r.frameP50 = Percentile(frameMs + skip, n, 0.50f);
+    r.frameP99 = Percentile(frameMs + skip, n, 0.99f);
+    r.frameMax = n > 0 ? frameMs[frameCount - 1] : 0.0f; // Last after sorting
+    r.cpuP99 = Percentile(cpuMs + skip, n, 0.99f);
+    return r;
+}
+
+int BenchWrite(const char *path, const BenchResult *r)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+        return 0;
+    fprintf(f, "frames %d\n", r->frames);
+    fprintf(f, "frame_p50_ms %.3f\n", r->frameP50);
+    fprintf(f, "frame_p99_ms %.3f\n", r->frameP99);
+    fprintf(f, "frame_max_ms %.3f\n", r->frameMax);
+    fprintf(f, "cpu_p99_ms %.3f\n", r->cpuP99);
+    fprintf(f, "batches_avg %.2f\n", r->batchesAvg);
+    fprintf(f, "peak_rss_kb %ld\n", r->peakRssKb);
+    fclose(f);
+    return 1;
+}
+
+int BenchRead(const char *path, BenchResult *r)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        return 0;
+    memset(r, 0, sizeof(*r));
+    char name[64];
+    double value;
+    int found = 0;
+    while (fscanf(f, "%63s %lf", name, &value) == 2)
+    {
+        found++;
+        if (strcmp(name, "frames") == 0)
+            r->frames = (int)value;
+        else if (strcmp(name, "frame_p50_ms") == 0)
+            r->frameP50 = (float)value;
+        else if (strcmp(name, "frame_p99_ms") == 0)
+            r->frameP99 = (float)value;
+        else if (strcmp(name, "frame_max_ms") == 0)
+            r->frameMax = (float)value;
+        else if (strcmp(name, "cpu_p99_ms") == 0)
+            r->cpuP99 = (float)value;
+        else if (strcmp(name, "batches_avg") == 0)
+            r->batchesAvg = (float)value;
+        else if (strcmp(name, "peak_rss_kb") == 0)
+            r->peakRssKb = (long)value;
+        else
+            found--;
+    }
+    fclose(f);
+    return found > 0;
+}
+
+// One table row; limit < 0 means reported but not checked. Growth below
+// minDelta never counts.
+static int CompareRow(const char *name, double base, double cur, float limit, double minDelta)
+{
+    double change = base > 0 ? (cur - base) / base * 100.0 : 0.0;
+    int broken = limit >= 0 && change > limit && cur - base > minDelta;
+    if (limit >= 0)
+        printf("%-14s %12.3f %12.3f %+8.1f%%  %+6.1f%%  %s\n", name, base, cur, change, limit,
+               broken ? "REGRESSED" : "ok");
+    else
+        printf("%-14s %12.3f %12.3f %+8.1f%%        -\n", name, base, cur, change);
+    return broken;
+}
+
+int BenchCompare(const BenchResult *baseline, const BenchResult *current, float maxTimePct, float maxMemPct)
+{
+    int broken = 0;
+    printf("%-14s %12s %12s %9s  %7s\n", "metric", "baseline", "current", "change", "limit");
+    CompareRow("frames", baseline->frames, current->frames, -1, 0);
+    CompareRow("frame_p50_ms", baseline->frameP50, current->frameP50, -1, 0);
+    broken += CompareRow("frame_p99_ms", baseline->frameP99, current->frameP99, maxTimePct, BENCH_MIN_TIME_DELTA);
+    CompareRow("frame_max_ms", baseline->frameMax, current->frameMax, -1, 0);
+    broken += CompareRow("cpu_p99_ms", baseline->cpuP99, current->cpuP99, maxTimePct, BENCH_MIN_TIME_DELTA);
+    CompareRow("batches_avg", baseline->batchesAvg, current->batchesAvg, -1, 0);
+    broken += CompareRow("peak_rss_kb", (double)baseline->peakRssKb, (double)current->peakRssKb, maxMemPct, 0);
+    if (baseline->frames != current->frames)
+        printf("note: frame counts differ, the replay or its baseline has changed\n");
+    return broken;
+}
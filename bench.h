@@ -0,0 +1,34 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Frame-loop benchmark for replayed sessions. Collects wall and process CPU
+// time for every frame, render batches and peak resident memory, writes them
+// as a small "name value" text report, and compares a run against a stored
+// baseline report with percentage limits.
+
+#define BENCH_MAX_FRAMES (1 << 18)
+#define BENCH_WARMUP_FRAMES 60 // Left out of the percentiles: loading, first uploads
+#define BENCH_MIN_TIME_DELTA 0.1 // ms; smaller growth is timer noise, whatever the percentage
+
+typedef struct
+{
+    int frames;
+    float frameP50;  // ms
+    float frameP99;  // ms
+    float frameMax;  // ms
+    float cpuP99;    // ms of process CPU time per frame, all threads
+    float batchesAvg; // Texture switches per frame, about one draw call each
+    long peakRssKb;
+} BenchResult;
+
+void BenchStart(void);
+void BenchFrameBegin(void);
+void BenchFrameEnd(int batches);
+BenchResult BenchFinish(void);
+
+int BenchWrite(const char *path, const BenchResult *r);
+int BenchRead(const char *path, BenchResult *r);
+// Prints a table of baseline against current; returns how many limits were broken
+int BenchCompare(const BenchResult *baseline, const BenchResult *current, float maxTimePct, float maxMemPct);
+
+#endif
@@ -0,0 +1,242 @@
+#include "board.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Zobrist keys. Powers are hashed one bit-plane at a time - a key per
+// (seat, row, slot, bit) - which keeps the table at a few KB instead of one
+// key per possible power value, and lets a power change XOR in only the bits
+// that flipped.
+static unsigned long long zOccupied[BOARD_SEATS][BOARD_ROWS][BOARD_SLOTS];
+static unsigned long long zHero[BOARD_SEATS][BOARD_ROWS][BOARD_SLOTS];
+static unsigned long long zPower[BOARD_SEATS][BOARD_ROWS][BOARD_SLOTS][8];
+static unsigned long long zFlags[32];
+static int zobristReady = 0;
+
+static unsigned long long SplitMix64(unsigned long long *state)
+{
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Fixed seed so hashes are the same in every process (game, server, tools).
+// Call once from main() before any thread touches a board; the hashing
+// paths only assert that it happened.
+void BoardInitZobrist(void)
+{
+    unsigned long long state = 0x474F5754484552ull; // "GOWTHER"
+    for (int s = 0; s < BOARD_SEATS; s++)
+        for (int r = 0; r < BOARD_ROWS; r++)
+            for (int i = 0; i < BOARD_SLOTS; i++)
+            {
+                zOccupied[s][r][i] = SplitMix64(&state);
+                zHero[s][r][i] = SplitMix64(&state);
+                for (int bit = 0; bit < 8; bit++)
+                    zPower[s][r][i][bit] = SplitMix64(&state);
+            }
+    for (int bit = 0; bit < 32; bit++)
+        zFlags[bit] = SplitMix64(&state);
+    zobristReady = 1;
+}
+
+static unsigned long long PowerKey(int seat, int row, int slot, unsigned int bits)
+{
+    unsigned long long key = 0;
+    while (bits)
+    {
+        key ^= zPower[seat][row][slot][__builtin_ctz(bits)];
+        bits &= bits - 1;
+    }
+    return key;
+}
+
+static unsigned long long FlagsKey(unsigned int bits)
+{
+    unsigned long long key = 0;
+    while (bits)
+    {
+        key ^= zFlags[__builtin_ctz(bits)];
+        bits &= bits - 1;
+    }
+    return key;
+}
+
+static unsigned char ClampPower(int power)
+{
+    return (unsigned char)(power < 0 ? 0 : power > 255 ? 255 : power);
+}
+
+void BoardClear(PackedBoard *b, unsigned long long *hash)
+{
+    assert(zobristReady);
+    memset(b, 0, sizeof(*b));
+    if (hash != NULL)
+        *hash = 0; // The empty board hashes to zero
+}
+
+// Put a card in the next free slot of a row. Returns the slot, or -1 if the
+// row is full. The hash, if given, is updated in place.
+int BoardPlace(PackedBoard *b, unsigned long long *hash, int seat, int row, int power, int isHero)
+{
+    unsigned int occupied = b->occupied[seat][row];
+    if (occupied == 0xFF)
+        return -1;
+
+    int slot = __builtin_popcount(occupied);
+    unsigned char p = ClampPower(power);
+    b->occupied[seat][row] = (unsigned char)(occupied | (1u << slot));
+    b->power[seat][row][slot] = p;
+    if (isHero)
+        b->hero[seat][row] |= (unsigned char)(1u << slot);
+
+    if (hash != NULL)
+    {
+        *hash ^= zOccupied[seat][row][slot] ^ PowerKey(seat, row, slot, p);
+        if (isHero)
+            *hash ^= zHero[seat][row][slot];
+    }
+    return slot;
+}
+
+void BoardSetPower(PackedBoard *b, unsigned long long *hash, int seat, int row, int slot, int power)
+{
+    unsigned char p = ClampPower(power);
+    if (hash != NULL)
+        *hash ^= PowerKey(seat, row, slot, b->power[seat][row][slot] ^ p);
+    b->power[seat][row][slot] = p;
+}
+
+void BoardSetFlags(PackedBoard *b, unsigned long long *hash, unsigned int flags)
+{
+    if (hash != NULL)
+        *hash ^= FlagsKey(b->flags ^ flags);
+    b->flags = flags;
+}
+
+// Full recomputation, for checking the incremental hash or hashing a
+// position built by hand
+unsigned long long BoardHash(const PackedBoard *b)
+{
+    assert(zobristReady);
+
+    unsigned long long key = FlagsKey(b->flags);
+    for (int s = 0; s < BOARD_SEATS; s++)
+        for (int r = 0; r < BOARD_ROWS; r++)
+        {
+            unsigned int occupied = b->occupied[s][r];
+            while (occupied)
+            {
+                int i = __builtin_ctz(occupied);
+                occupied &= occupied - 1;
+                key ^= zOccupied[s][r][i] ^ PowerKey(s, r, i, b->power[s][r][i]);
+                if (b->hero[s][r] & (1u << i))
+                    key ^= zHero[s][r][i];
+            }
+        }
+    return key;
+}
+
+//----------------------------------------------------------------------------------
+// Scoring. Empty slots hold power 0, so a row's score is the plain sum of its
+// eight bytes and never needs the occupancy mask.
+//----------------------------------------------------------------------------------
+static unsigned long long RowWord(const PackedBoard *b, int seat, int row)
+{
+    unsigned long long w;
+    memcpy(&w, b->power[seat][row], sizeof(w));
+    return w;
+}
+
+// Horizontal add of eight bytes: fold to four 16-bit lanes, then sum the lanes
+static int SumBytes(unsigned long long w)
+{
+    w = (w & 0x00FF00FF00FF00FFull) + ((w >> 8) & 0x00FF00FF00FF00FFull);
+    return (int)((w * 0x0001000100010001ull) >> 48);
+}
+
+int BoardRowScore(const PackedBoard *b, int seat, int row)
+{
+    return SumBytes(RowWord(b, seat, row));
+}
+
+// Both seats' totals. With SSE2 each PSADBW sums two rows at once, so the
+// whole 48-byte power block takes three loads and three instructions.
+void BoardScores(const PackedBoard *b, int totals[BOARD_SEATS])
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i *p = (const __m128i *)b->power;
+    __m128i a = _mm_sad_epu8(_mm_loadu_si128(p + 0), zero); // seat 0 rows 0, 1
+    __m128i c = _mm_sad_epu8(_mm_loadu_si128(p + 1), zero); // seat 0 row 2, seat 1 row 0
+    __m128i d = _mm_sad_epu8(_mm_loadu_si128(p + 2), zero); // seat 1 rows 1, 2
+    totals[0] = _mm_cvtsi128_si32(a) + _mm_extract_epi16(a, 4) + _mm_cvtsi128_si32(c);
+    totals[1] = _mm_extract_epi16(c, 4) + _mm_cvtsi128_si32(d) + _mm_extract_epi16(d, 4);
+#else
+    for (int s = 0; s < BOARD_SEATS; s++)
+        totals[s] = SumBytes(RowWord(b, s, 0)) + SumBytes(RowWord(b, s, 1)) + SumBytes(RowWord(b, s, 2));
+#endif
+}
+
+int BoardTotal(const PackedBoard *b, int seat)
+{
+    int totals[BOARD_SEATS];
+    BoardScores(b, totals);
+    return totals[seat];
+}
+
+// Score lead from `seat`'s point of view
+int BoardEvaluate(const PackedBoard *b, int seat)
+{
+    int totals[BOARD_SEATS];
+    BoardScores(b, totals);
+    return totals[seat] - totals[1 - seat];
+}
+
+int BoardRowCount(const PackedBoard *b, int seat, int row)
+{
+    return __builtin_popcount(b->occupied[seat][row]);
+}
+
+int BoardCardCount(const PackedBoard *b, int seat)
+{
+    unsigned int bits = b->occupied[seat][0] | (b->occupied[seat][1] << 8) | (b->occupied[seat][2] << 16);
+    return __builtin_popcount(bits);
+}
+
+//----------------------------------------------------------------------------------
+// Transposition table
+//----------------------------------------------------------------------------------
+int BoardTableInit(BoardTable *t, int log2Entries)
+{
+    assert(zobristReady);
+    t->entries = calloc((size_t)1 << log2Entries, sizeof(BoardTableEntry));
+    t->mask = t->entries != NULL ? (1u << log2Entries) - 1 : 0;
+    return t->entries != NULL;
+}
+
+void BoardTableFree(BoardTable *t)
+{
+    free(t->entries);
+    t->entries = NULL;
+    t->mask = 0;
+}
+
+// Entry stored for this key, or NULL. Key 0 (the empty board) is never stored.
+BoardTableEntry *BoardTableProbe(BoardTable *t, unsigned long long key)
+{
+    BoardTableEntry *e = &t->entries[key & t->mask];
+    return (key != 0 && e->key == key) ? e : NULL;
+}
+
+void BoardTableStore(BoardTable *t, unsigned long long key, int value, int depth)
+{
+    BoardTableEntry *e = &t->entries[key & t->mask];
+    e->key = key;
+    e->value = value;
+    e->depth = depth;
+}
@@ -0,0 +1,60 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// Packed board position: everything that decides the score in one 64-byte,
+// cache-line aligned block. Rows fill from slot 0, so a row's occupancy is a
+// run of low bits and its eight powers are one 64-bit word. Scoring sums
+// those words with SSE2 (or plain 64-bit arithmetic elsewhere), and positions
+// carry a Zobrist hash for transposition tables.
+
+#define BOARD_SEATS 2
+#define BOARD_ROWS 3
+#define BOARD_SLOTS 8
+
+// flags layout
+#define BOARD_WEATHER_MASK 0x000000FFu // WEATHER_* bits
+#define BOARD_SHIELD(seat) (0x100u << (seat))
+#define BOARD_TURN 0x400u // Set when seat 1 is to move
+
+typedef struct
+{
+    unsigned char power[BOARD_SEATS][BOARD_ROWS][BOARD_SLOTS]; // 0 when empty
+    unsigned char occupied[BOARD_SEATS][BOARD_ROWS];           // Bit i: slot i holds a card
+    unsigned char hero[BOARD_SEATS][BOARD_ROWS];               // Bit i: that card is a hero
+    unsigned int flags;
+} __attribute__((aligned(64))) PackedBoard;
+
+typedef struct
+{
+    unsigned long long key;
+    int value;
+    int depth;
+} BoardTableEntry;
+
+// Fixed-size, always-replace transposition table
+typedef struct
+{
+    BoardTableEntry *entries;
+    unsigned int mask;
+} BoardTable;
+
+void BoardInitZobrist(void);
+void BoardClear(PackedBoard *b, unsigned long long *hash);
+int BoardPlace(PackedBoard *b, unsigned long long *hash, int seat, int row, int power, int isHero);
+void BoardSetPower(PackedBoard *b, unsigned long long *hash, int seat, int row, int slot, int power);
+void BoardSetFlags(PackedBoard *b, unsigned long long *hash, unsigned int flags);
+unsigned long long BoardHash(const PackedBoard *b);
+
+int BoardRowScore(const PackedBoard *b, int seat, int row);
+void BoardScores(const PackedBoard *b, int totals[BOARD_SEATS]);
+int BoardTotal(const PackedBoard *b, int seat);
+int BoardEvaluate(const PackedBoard *b, int seat);
+int BoardRowCount(const PackedBoard *b, int seat, int row);
+int BoardCardCount(const PackedBoard *b, int seat);
+
+int BoardTableInit(BoardTable *t, int log2Entries);
+void BoardTableFree(BoardTable *t);
+BoardTableEntry *BoardTableProbe(BoardTable *t, unsigned long long key);
+void BoardTableStore(BoardTable *t, unsigned long long key, int value, int depth);
+
+#endif
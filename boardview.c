@@ -0,0 +1,102 @@
+#include "boardview.h"
+
+static CardArt LoadCardArt(const CardDef *def)
+{
+    CardArt art;
+    ResourceHandle img = ResLoadImage(def->image, SCOPE_GLOBAL);
+
+    // Normal and rotated textures; the source image is left untouched
+    art.normTex = ResLoadTextureFromImage(img, 0, SCOPE_GLOBAL);
+    art.rotatedTex = ResLoadTextureFromImage(img, 1, SCOPE_GLOBAL);
+
+    // Pixels are on the GPU now, drop the CPU copy
+    ResRelease(img);
+    return art;
+}
+
+void BoardArtLoad(BoardArt *art)
+{
+    for (int i = 0; i < CARD_DEF_COUNT; i++)
+        art->cards[i] = LoadCardArt(&cardDefs[i]);
+
+    art->gameBoard = ResLoadTexture("gameBoard.jpg", SCOPE_MATCH);
+    art->upboard = ResLoadTexture("upboard.png", SCOPE_MATCH);
+    art->downboard = ResLoadTexture("downboard.png", SCOPE_MATCH);
+    art->timer = ResLoadTexture("time.png", SCOPE_MATCH);
+    art->score = ResLoadTexture("score.png", SCOPE_MATCH);
+    art->frost = ResLoadTexture("frost.jpg", SCOPE_MATCH);
+}
+
+void BoardArtSprites(const BoardArt *art, Texture2D *sprites)
+{
+    sprites[SPRITE_GAME_BOARD] = ResGetTexture(art->gameBoard);
+    sprites[SPRITE_UPBOARD] = ResGetTexture(art->upboard);
+    sprites[SPRITE_DOWNBOARD] = ResGetTexture(art->downboard);
+    sprites[SPRITE_TIMER] = ResGetTexture(art->timer);
+    sprites[SPRITE_SCORE] = ResGetTexture(art->score);
+    sprites[SPRITE_FROST] = ResGetTexture(art->frost);
+    for (int i = 0; i < CARD_DEF_COUNT; i++)
+    {
+        sprites[SPRITE_CARD + i] = ResGetTexture(art->cards[i].normTex);
+        sprites[SPRITE_CARD_ROTATED + i] = ResGetTexture(art->cards[i].rotatedTex);
+    }
+}
+
+void RenderMatchView(RenderList *list, const MatchView *v)
+{
+    RenderSprite(list, LAYER_BOARD, SPRITE_GAME_BOARD, 0, 0, WHITE);
+
+    // Scrolling cards, passing under the top and bottom frames
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        if (v->slots[i] == 0)
+            continue;
+        float x = VIEW_WIDTH / 2 - VIEW_CARD_WIDTH / 2;
+        float y = v->offset + i * v->pitch;
+        RenderSprite(list, LAYER_CARDS, SPRITE_CARD + v->slots[i] - 1, x, y, WHITE);
+    }
+    RenderSprite(list, LAYER_FRAME, SPRITE_UPBOARD, 609, 0, WHITE);
+    RenderSprite(list, LAYER_FRAME, SPRITE_DOWNBOARD, 607, 702, WHITE);
+    RenderSprite(list, LAYER_FRAME, SPRITE_TIMER, 618, 0, BROWN);
+    RenderSprite(list, LAYER_FRAME, SPRITE_TIMER, 618, 640, BROWN);
+
+    // Rows, melee nearest the centre; seat 0 on the left, seat 1 mirrored
+    const int rowX[MATCH_PLAYERS][MATCH_ROWS] = {{463, 311, 159}, {768, 920, 1072}};
+    const int scoreX[MATCH_PLAYERS][MATCH_ROWS] = {{494, 342, 190}, {805, 957, 1102}};
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            for (int i = 0; i < MAX_ROW_CARDS && v->rows[s][r][i] != 0; i++)
+            {
+                int y = 65 + 4 + i * 79;
+                RenderSprite(list, LAYER_CARDS, SPRITE_CARD_ROTATED + v->rows[s][r][i] - 1, rowX[s][r], y, WHITE);
+            }
+        }
+    }
+    if (v->weather & WEATHER_FROST)
+    {
+        RenderSprite(list, LAYER_WEATHER, SPRITE_FROST, 464, 76, Fade(WHITE, 0.7f));
+        RenderSprite(list, LAYER_WEATHER, SPRITE_FROST, 766, 76, Fade(WHITE, 0.7f));
+    }
+
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            RenderSprite(list, LAYER_SCORE, SPRITE_SCORE, scoreX[s][r], 681, BROWN);
+            RenderText(list, LAYER_SCORE_TEXT, scoreX[s][r] + 23, 700, 30, WHITE, "%d", v->rowScores[s][r]);
+        }
+    }
+}
+
+void DrawMatchView(const BoardArt *art, const MatchView *v)
+{
+    static RenderList list;
+    Texture2D sprites[SPRITE_BOARD_COUNT];
+    BoardArtSprites(art, sprites);
+    RenderListClear(&list);
+    RenderMatchView(&list, v);
+    RenderListSort(&list);
+    RenderListSubmit(&list, sprites, SPRITE_BOARD_COUNT);
+}
@@ -0,0 +1,68 @@
+#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+#include "raylib.h"
+#include "resources.h"
+#include "matchview.h"
+#include "render.h"
+
+// Drawing of the match screen from a MatchView, shared by the game and the
+// spectator client. Coordinates are for the 1366x768 board.
+//
+// RenderMatchView only adds commands to a render list, so it can run off the
+// GL thread; the list names artwork by the sprite ids below, which
+// BoardArtSprites resolves to textures.
+
+#define VIEW_WIDTH 1366
+#define VIEW_HEIGHT 768
+#define VIEW_CARD_WIDTH 79
+
+// Artwork for one card definition, shared by every instance of it
+typedef struct
+{
+    ResourceHandle normTex;
+    ResourceHandle rotatedTex;
+} CardArt;
+
+typedef struct
+{
+    CardArt cards[CARD_DEF_COUNT];
+    ResourceHandle gameBoard;
+    ResourceHandle upboard;
+    ResourceHandle downboard;
+    ResourceHandle timer;
+    ResourceHandle score;
+    ResourceHandle frost;
+} BoardArt;
+
+typedef enum
+{
+    SPRITE_GAME_BOARD,
+    SPRITE_UPBOARD,
+    SPRITE_DOWNBOARD,
+    SPRITE_TIMER,
+    SPRITE_SCORE,
+    SPRITE_FROST,
+    SPRITE_CARD,                                        // + def id
+    SPRITE_CARD_ROTATED = SPRITE_CARD + CARD_DEF_COUNT, // + def id
+    SPRITE_BOARD_COUNT = SPRITE_CARD_ROTATED + CARD_DEF_COUNT
+} BoardSprite;
+
+// Layers of the match screen, bottom to top
+typedef enum
+{
+    LAYER_BOARD,
+    LAYER_CARDS, // Carousel and rows
+    LAYER_FRAME, // Over the ends of the carousel
+    LAYER_WEATHER,
+    LAYER_SCORE,
+    LAYER_SCORE_TEXT,
+    LAYER_BOARD_COUNT
+} BoardLayer;
+
+void BoardArtLoad(BoardArt *art); // Needs ResInit and a window
+void BoardArtSprites(const BoardArt *art, Texture2D *sprites); // Fills SPRITE_BOARD_COUNT entries
+void RenderMatchView(RenderList *list, const MatchView *v);
+void DrawMatchView(const BoardArt *art, const MatchView *v); // Render and submit in one go
+
+#endif
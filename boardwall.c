@@ -0,0 +1,108 @@
+#include "boardwall.h"
+#include <math.h>
+
+#define BOT_MIN_DELAY 0.3 // Seconds into a turn before a bot first tries
+#define BOT_RETRY 0.05    // Between tries while the selection zone is empty
+
+static float Random01(BoardWall *w)
+{
+    return (CardRandom(&w->rng) & 0xFFFFFF) / (float)0x1000000;
+}
+
+// A new bot decision for the seat to move, somewhere in the first part of its turn
+static void ScheduleBot(BoardWall *w, WallBoard *b, double now)
+{
+    float window = b->match.config.turnTime * 0.7f - BOT_MIN_DELAY;
+    b->turn = b->match.turn;
+    b->nextPick = now + BOT_MIN_DELAY + Random01(w) * (window > 0 ? window : 0);
+}
+
+static void StartMatch(BoardWall *w, WallBoard *b, double now)
+{
+    MatchConfig config = MatchDefaultConfig();
+    config.speed = WALL_MIN_SPEED + Random01(w) * (WALL_MAX_SPEED - WALL_MIN_SPEED);
+    MatchInit(&b->match, &config, CardRandom(&w->rng), now);
+    b->restartAt = 0.0;
+    ScheduleBot(w, b, now);
+    w->matchesStarted++;
+}
+
+void BoardWallInit(BoardWall *w, int count, unsigned int seed, double now)
+{
+    w->count = 0;
+    w->rng = seed;
+    w->matchesStarted = 0;
+    w->picks = 0;
+    BoardWallResize(w, count, now);
+}
+
+// Boards that stay keep their matches; new ones start fresh
+void BoardWallResize(BoardWall *w, int count, double now)
+{
+    if (count < 1)
+        count = 1;
+    if (count > WALL_MAX_BOARDS)
+        count = WALL_MAX_BOARDS;
+    for (int i = w->count; i < count; i++)
+        StartMatch(w, &w->boards[i], now);
+    w->count = count;
+}
+
+void BoardWallUpdate(BoardWall *w, double now)
+{
+    for (int i = 0; i < w->count; i++)
+    {
+        WallBoard *b = &w->boards[i];
+        if (b->restartAt > 0.0)
+        {
+            if (now >= b->restartAt)
+                StartMatch(w, b, now);
+        }
+        else
+        {
+            // The seat may have timed out since the last frame
+            MatchTick(&b->match, now);
+            if (b->match.turn != b->turn)
+                ScheduleBot(w, b, now);
+
+            if (!b->match.over && now >= b->nextPick)
+            {
+                if (MatchPick(&b->match, b->match.turn, now) != -1)
+                {
+                    w->picks++;
+                    ScheduleBot(w, b, now);
+                }
+                else
+                {
+                    b->nextPick = now + BOT_RETRY;
+                }
+            }
+            if (b->match.over)
+                b->restartAt = now + WALL_RESTART_DELAY;
+        }
+        MatchViewCapture(&b->view, &b->match, (unsigned int)i + 1, now);
+    }
+}
+
+void RenderBoardWall(RenderList *list, const BoardWall *w, float width, float height)
+{
+    int cols = (int)ceilf(sqrtf((float)w->count));
+    int rows = (w->count + cols - 1) / cols;
+    float tileW = width / cols, tileH = height / rows;
+    float scale = fminf(tileW / VIEW_WIDTH, tileH / VIEW_HEIGHT);
+
+    // Tiles keep the board's aspect ratio, centred in their cell
+    for (int i = 0; i < w->count; i++)
+    {
+        const WallBoard *b = &w->boards[i];
+        float x = (i % cols) * tileW + (tileW - VIEW_WIDTH * scale) / 2;
+        float y = (i / cols) * tileH + (tileH - VIEW_HEIGHT * scale) / 2;
+        RenderListSetTransform(list, x, y, scale);
+        RenderListSetClip(list, (Rectangle){0, 0, VIEW_WIDTH, VIEW_HEIGHT});
+
+        RenderMatchView(list, &b->view);
+        RenderText(list, LAYER_SCORE_TEXT, 20, 20, 40, YELLOW, "#%d  %.0f px/s  %d - %d%s", i + 1, b->view.speed,
+                   BoardTotal(&b->match.board, 0), BoardTotal(&b->match.board, 1), b->match.over ? "  final" : "");
+    }
+    RenderListSetTransform(list, 0, 0, 1.0f);
+}
@@ -0,0 +1,41 @@
+#ifndef BOARDWALL_H
+#define BOARDWALL_H
+
+#include "boardview.h"
+
+// Several live matches on one screen, for attract-mode and tournament
+// displays and as a load test for the renderer. Every board runs its own
+// match with its own carousel speed, both seats played by bots, and starts a
+// new match a few seconds after one ends. All boards are drawn into one
+// render list with the same sprites, scaled into a grid of tiles, so each
+// card texture is still drawn in one run however many boards show it.
+
+#define WALL_MAX_BOARDS 16
+#define WALL_MIN_SPEED 60.0f  // px/sec
+#define WALL_MAX_SPEED 320.0f // px/sec
+#define WALL_RESTART_DELAY 3.0
+
+typedef struct
+{
+    MatchState match;
+    MatchView view;
+    int turn;         // Seat the bot schedule below is for
+    double nextPick;  // When that seat's bot tries to pick
+    double restartAt; // When a finished match is replaced, 0 while it runs
+} WallBoard;
+
+typedef struct
+{
+    WallBoard boards[WALL_MAX_BOARDS];
+    int count;
+    unsigned int rng;
+    unsigned int matchesStarted;
+    unsigned int picks;
+} BoardWall;
+
+void BoardWallInit(BoardWall *w, int count, unsigned int seed, double now);
+void BoardWallResize(BoardWall *w, int count, double now);
+void BoardWallUpdate(BoardWall *w, double now);
+void RenderBoardWall(RenderList *list, const BoardWall *w, float width, float height);
+
+#endif
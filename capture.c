@@ -0,0 +1,342 @@
+#include "capture.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(PLATFORM_DESKTOP)
+
+// raylib only wraps the GL it needs itself; the pixel pack path is loaded
+// here through GLFW, which raylib already links
+#if defined(_WIN32)
+#define CAPTURE_GLAPI __stdcall
+#else
+#define CAPTURE_GLAPI
+#endif
+
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+#define GL_RGBA 0x1908
+#define GL_UNSIGNED_BYTE 0x1401
+
+typedef void (*CaptureProc)(void);
+extern CaptureProc glfwGetProcAddress(const char *procname);
+
+typedef void(CAPTURE_GLAPI *GenBuffersProc)(int n, unsigned int *buffers);
+typedef void(CAPTURE_GLAPI *DeleteBuffersProc)(int n, const unsigned int *buffers);
+typedef void(CAPTURE_GLAPI *BindBufferProc)(unsigned int target, unsigned int buffer);
+typedef void(CAPTURE_GLAPI *BufferDataProc)(unsigned int target, ptrdiff_t size, const void *data, unsigned int usage);
+typedef void(CAPTURE_GLAPI *ReadPixelsProc)(int x, int y, int w, int h, unsigned int format, unsigned int type, void *pixels);
+typedef void *(CAPTURE_GLAPI *MapBufferRangeProc)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access);
+typedef unsigned char(CAPTURE_GLAPI *UnmapBufferProc)(unsigned int target);
+
+static GenBuffersProc glGenBuffers_;
+static DeleteBuffersProc glDeleteBuffers_;
+static BindBufferProc glBindBuffer_;
+static BufferDataProc glBufferData_;
+static ReadPixelsProc glReadPixels_;
+static MapBufferRangeProc glMapBufferRange_;
+static UnmapBufferProc glUnmapBuffer_;
+
+static int LoadGL(void)
+{
+    glGenBuffers_ = (GenBuffersProc)glfwGetProcAddress("glGenBuffers");
+    glDeleteBuffers_ = (DeleteBuffersProc)glfwGetProcAddress("glDeleteBuffers");
+    glBindBuffer_ = (BindBufferProc)glfwGetProcAddress("glBindBuffer");
+    glBufferData_ = (BufferDataProc)glfwGetProcAddress("glBufferData");
+    glReadPixels_ = (ReadPixelsProc)glfwGetProcAddress("glReadPixels");
+    glMapBufferRange_ = (MapBufferRangeProc)glfwGetProcAddress("glMapBufferRange");
+    glUnmapBuffer_ = (UnmapBufferProc)glfwGetProcAddress("glUnmapBuffer");
+    return glGenBuffers_ && glDeleteBuffers_ && glBindBuffer_ && glBufferData_ && glReadPixels_ &&
+           glMapBufferRange_ && glUnmapBuffer_;
+}
+
+static struct
+{
+    int active;
+    CaptureFormat format;
+    char prefix[CAPTURE_MAX_PATH];
+    FILE *file;
+    int width, height;
+    size_t frameBytes;
+    double startTime;
+
+    // Readback: frame N goes into pbo[N & 1] and is mapped during frame N + 1
+    unsigned int pbo[2];
+    unsigned int readCount;
+
+    // Encoder queue, guarded by lock. repeats[] counts frames dropped right
+    // after each queued one, which the encoder fills in to keep the timeline.
+    unsigned char *frames[CAPTURE_QUEUE_FRAMES];
+    unsigned int repeats[CAPTURE_QUEUE_FRAMES];
+    unsigned int head, tail;
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t encoder;
+
+    unsigned int captured, dropped;
+    float frameMs;
+} cap;
+
+// `frame` is the game frame's position in the recording; `copies` is 1 plus
+// the number of frames dropped after it
+static void WriteFrame(unsigned char *pixels, unsigned int frame, unsigned int copies)
+{
+    int stride = cap.width * 4;
+
+    // GL rows are bottom-up; files are written top-down
+    if (cap.format == CAPTURE_RAW)
+    {
+        for (unsigned int i = 0; i < copies; i++)
+        {
+            for (int y = cap.height - 1; y >= 0; y--)
+                fwrite(pixels + (size_t)y * stride, 1, stride, cap.file);
+        }
+        return;
+    }
+
+    unsigned char *row = malloc(stride);
+    for (int y = 0; y < cap.height / 2; y++)
+    {
+        unsigned char *a = pixels + (size_t)y * stride;
+        unsigned char *b = pixels + (size_t)(cap.height - 1 - y) * stride;
+        memcpy(row, a, stride);
+        memcpy(a, b, stride);
+        memcpy(b, row, stride);
+    }
+    free(row);
+
+    // TextFormat's buffers belong to the main thread
+    char path[CAPTURE_MAX_PATH + 16];
+    snprintf(path, sizeof(path), "%s_%05u.png", cap.prefix, frame + 1);
+    Image image = {pixels, cap.width, cap.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    ExportImage(image, path);
+}
+
+static void *EncoderMain(void *arg)
+{
+    (void)arg;
+    unsigned int frame = 0;
+    pthread_mutex_lock(&cap.lock);
+    for (;;)
+    {
+        while (cap.head == cap.tail && !cap.stopping)
+            pthread_cond_wait(&cap.wake, &cap.lock);
+        if (cap.head == cap.tail)
+            break; // Stopping and drained
+
+        // Drops only ever add to the newest queued frame, and the queue is
+        // full then, so this slot's count is final once it reaches the tail
+        unsigned int slot = cap.tail % CAPTURE_QUEUE_FRAMES;
+        unsigned int copies = 1 + cap.repeats[slot];
+        cap.repeats[slot] = 0;
+        pthread_mutex_unlock(&cap.lock);
+        WriteFrame(cap.frames[slot], frame, copies);
+        frame += copies;
+        pthread_mutex_lock(&cap.lock);
+        cap.tail++;
+    }
+    pthread_mutex_unlock(&cap.lock);
+    return NULL;
+}
+
+// Copy the previous frame's pixels out of its PBO into the queue, or drop it
+static void Collect(unsigned int pbo)
+{
+    glBindBuffer_(GL_PIXEL_PACK_BUFFER, pbo);
+    void *pixels = glMapBufferRange_(GL_PIXEL_PACK_BUFFER, 0, (ptrdiff_t)cap.frameBytes, GL_MAP_READ_BIT);
+    if (pixels != NULL)
+    {
+        pthread_mutex_lock(&cap.lock);
+        int full = cap.head - cap.tail >= CAPTURE_QUEUE_FRAMES;
+        unsigned int index = cap.head;
+        if (full)
+            cap.repeats[(index - 1) % CAPTURE_QUEUE_FRAMES]++;
+        pthread_mutex_unlock(&cap.lock);
+
+        if (full)
+            cap.dropped++;
+        else
+        {
+            // The encoder never touches slots at or past head, so no lock here
+            memcpy(cap.frames[index % CAPTURE_QUEUE_FRAMES], pixels, cap.frameBytes);
+            pthread_mutex_lock(&cap.lock);
+            cap.head++;
+            pthread_cond_signal(&cap.wake);
+            pthread_mutex_unlock(&cap.lock);
+            cap.captured++;
+        }
+        glUnmapBuffer_(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer_(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+int CaptureStart(const char *prefix, CaptureFormat format)
+{
+    if (cap.active)
+        return 1;
+    if (!LoadGL())
+    {
+        TraceLog(LOG_WARNING, "CAPTURE: Pixel buffer objects not available");
+        return 0;
+    }
+
+    memset(&cap, 0, sizeof(cap));
+    cap.format = format;
+    snprintf(cap.prefix, sizeof(cap.prefix), "%s", prefix);
+    cap.width = GetRenderWidth();
+    cap.height = GetRenderHeight();
+    cap.frameBytes = (size_t)cap.width * cap.height * 4;
+
+    if (format == CAPTURE_RAW && (cap.file = fopen(TextFormat("%s.rgba", prefix), "wb")) == NULL)
+    {
+        TraceLog(LOG_WARNING, "CAPTURE: Could not open %s.rgba", prefix);
+        return 0;
+    }
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++)
+    {
+        if ((cap.frames[i] = malloc(cap.frameBytes)) == NULL)
+        {
+            CaptureStop();
+            return 0;
+        }
+    }
+
+    glGenBuffers_(2, cap.pbo);
+    for (int i = 0; i < 2; i++)
+    {
+        glBindBuffer_(GL_PIXEL_PACK_BUFFER, cap.pbo[i]);
+        glBufferData_(GL_PIXEL_PACK_BUFFER, (ptrdiff_t)cap.frameBytes, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer_(GL_PIXEL_PACK_BUFFER, 0);
+
+    pthread_mutex_init(&cap.lock, NULL);
+    pthread_cond_init(&cap.wake, NULL);
+    cap.active = 1;
+    if (pthread_create(&cap.encoder, NULL, EncoderMain, NULL) != 0)
+    {
+        cap.active = 0;
+        CaptureStop();
+        return 0;
+    }
+    cap.startTime = GetTime();
+    TraceLog(LOG_INFO, "CAPTURE: Recording %dx%d to %s%s", cap.width, cap.height, prefix,
+             format == CAPTURE_RAW ? ".rgba" : "_*.png");
+    return 1;
+}
+
+void CaptureFrame(void)
+{
+    if (!cap.active)
+        return;
+    double start = GetTime();
+
+    // A resize would change the frame size mid-stream
+    if (GetRenderWidth() != cap.width || GetRenderHeight() != cap.height)
+    {
+        TraceLog(LOG_WARNING, "CAPTURE: Render size changed, stopping");
+        CaptureStop();
+        return;
+    }
+
+    // Everything raylib has batched must reach the framebuffer first
+    rlDrawRenderBatchActive();
+
+    // Queue this frame's read; it completes on the GPU in the background
+    glBindBuffer_(GL_PIXEL_PACK_BUFFER, cap.pbo[cap.readCount & 1]);
+    glReadPixels_(0, 0, cap.width, cap.height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer_(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Last frame's read has had a whole frame to finish
+    if (cap.readCount > 0)
+        Collect(cap.pbo[(cap.readCount - 1) & 1]);
+    cap.readCount++;
+
+    cap.frameMs = (float)((GetTime() - start) * 1000.0);
+}
+
+void CaptureStop(void)
+{
+    if (cap.active)
+    {
+        if (cap.readCount > 0)
+            Collect(cap.pbo[(cap.readCount - 1) & 1]);
+
+        pthread_mutex_lock(&cap.lock);
+        cap.stopping = 1;
+        pthread_cond_signal(&cap.wake);
+        pthread_mutex_unlock(&cap.lock);
+        pthread_join(cap.encoder, NULL);
+        pthread_mutex_destroy(&cap.lock);
+        pthread_cond_destroy(&cap.wake);
+
+        TraceLog(LOG_INFO, "CAPTURE: %u frames written, %u dropped", cap.captured, cap.dropped);
+        if (cap.format == CAPTURE_RAW)
+            TraceLog(LOG_INFO, "CAPTURE: One frame per game frame, drops repeated; at the 60 FPS target encode with: "
+                               "ffmpeg -f rawvideo -pix_fmt rgba -s %dx%d -framerate 60 -i %s.rgba %s.mp4",
+                     cap.width, cap.height, cap.prefix, cap.prefix);
+    }
+
+    if (cap.pbo[0] != 0)
+        glDeleteBuffers_(2, cap.pbo);
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++)
+        free(cap.frames[i]);
+    if (cap.file != NULL)
+        fclose(cap.file);
+    memset(&cap, 0, sizeof(cap));
+}
+
+int CaptureIsActive(void)
+{
+    return cap.active;
+}
+
+CaptureStats CaptureGetStats(void)
+{
+    CaptureStats s = {0};
+    s.active = cap.active;
+    s.width = cap.width;
+    s.height = cap.height;
+    s.captured = cap.captured;
+    s.dropped = cap.dropped;
+    s.seconds = cap.active ? GetTime() - cap.startTime : 0.0;
+    s.frameMs = cap.frameMs;
+    return s;
+}
+
+#else
+
+// GL ES builds have no buffer mapping to read back with
+int CaptureStart(const char *prefix, CaptureFormat format)
+{
+    (void)prefix;
+    (void)format;
+    TraceLog(LOG_WARNING, "CAPTURE: Not supported on this platform");
+    return 0;
+}
+
+void CaptureFrame(void)
+{
+}
+
+void CaptureStop(void)
+{
+}
+
+int CaptureIsActive(void)
+{
+    return 0;
+}
+
+CaptureStats CaptureGetStats(void)
+{
+    CaptureStats s = {0};
+    return s;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// In-game recording. Each frame is read back into one of two pixel buffer
+// objects and mapped a frame later, once the GPU has finished with it, so the
+// render thread never waits on the read. Frames are copied into a small queue
+// and written out by an encoder thread; if the encoder falls behind, frames
+// are dropped rather than slowing the game down. The output keeps one entry
+// per game frame regardless: the raw stream repeats the frame before a drop,
+// and image files are numbered by game frame, leaving gaps. Desktop OpenGL only.
+
+#define CAPTURE_QUEUE_FRAMES 6 // Frames waiting for the encoder
+#define CAPTURE_MAX_PATH 256
+
+typedef enum
+{
+    CAPTURE_RAW,   // One top-down RGBA stream, prefix.rgba (fast, large)
+    CAPTURE_IMAGES // prefix_00001.png ... numbered by game frame (slow, drops frames at 60 FPS)
+} CaptureFormat;
+
+typedef struct
+{
+    int active;
+    int width, height;
+    unsigned int captured; // Frames handed to the encoder
+    unsigned int dropped;  // Frames lost to a full queue, repeated in the raw stream
+    double seconds;        // Since CaptureStart
+    float frameMs;         // Main-thread cost of the last CaptureFrame
+} CaptureStats;
+
+int CaptureStart(const char *prefix, CaptureFormat format);
+void CaptureFrame(void); // After the frame is drawn, before EndDrawing
+void CaptureStop(void);
+int CaptureIsActive(void);
+CaptureStats CaptureGetStats(void);
+
+#endif
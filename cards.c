@@ -0,0 +1,98 @@
+#include "cards.h"
+#include <stddef.h>
+
+const CardDef cardDefs[CARD_DEF_COUNT] = {
+    {CARD_NORMAL, ROW_MELEE, 3, 0, 0, "mughalSoldier.png", NULL},
+    {CARD_SPECIAL_UNIT, ROW_MELEE, 3, 0, 1, "bangabaltu.png", "add self own 2"},
+    {CARD_HERO, ROW_SIEGE, 15, 1, 0, "clawarchi.png", NULL},
+    {CARD_WEATHER, ROW_GLOBAL, 0, 0, 2, "fog.png", "weather fog; set exposed ranged 1"},
+    {CARD_WEATHER, ROW_GLOBAL, 0, 0, 1, "frostbite.png", "weather frost; set exposed melee 1"},
+    {CARD_NORMAL, ROW_SIEGE, 8, 0, 0, "trebuchet.png", NULL},
+    {CARD_HERO, ROW_MELEE, 15, 1, 0, "khalid bin walid.png", NULL},
+    {CARD_NORMAL, ROW_RANGED, 6, 0, 0, "mongolArcher.png", NULL},
+    {CARD_HERO, ROW_RANGED, 15, 1, 0, "odysseus.png", NULL},
+    {CARD_WEATHER, ROW_GLOBAL, 0, 0, 3, "storm.png", "weather storm; halve exposed siege"},
+    {CARD_LEADER, ROW_GLOBAL, 0, 0, 0, "suleiman.png", "shield self; add self all 1"},
+    {CARD_LEADER, ROW_GLOBAL, 0, 0, 0, "hitler.png", "steal 4"},
+};
+
+// xorshift32: every match owns its generator, so draws are reproducible from
+// the seed and matches on different threads never share state
+unsigned int CardRandom(unsigned int *state)
+{
+    unsigned int x = *state ? *state : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Leaders are rare: one card in about thirty-three
+int CardRandomDefId(unsigned int *rng, int totalDefs)
+{
+    int r = CardRandom(rng) % 100;
+    CardType chosenType;
+    if (r >= 0 && r <= 70)
+        chosenType = CARD_NORMAL;
+    else if (r > 70 && r <= 80)
+        chosenType = CARD_WEATHER;
+    else if (r > 80 && r <= 90)
+        chosenType = CARD_SPECIAL_UNIT;
+    else if (r > 90 && r <= 96)
+        chosenType = CARD_HERO;
+    else
+        chosenType = CARD_LEADER;
+
+    int idx = -1;
+    while (idx == -1)
+    {
+        int randIdx = CardRandom(rng) % totalDefs;
+        if (cardDefs[randIdx].type == chosenType)
+            idx = randIdx;
+    }
+    return idx;
+}
+
+void CardPoolInit(CardPool *pool)
+{
+    for (int i = 0; i < CARD_POOL_CAPACITY; i++)
+    {
+        pool->generation[i] = 1;
+        pool->flags[i] = 0;
+        // Hand out low slots first so live instances stay packed
+        pool->freeSlots[i] = (unsigned char)(CARD_POOL_CAPACITY - 1 - i);
+    }
+    pool->freeCount = CARD_POOL_CAPACITY;
+}
+
+CardHandle CardSpawn(CardPool *pool, int defId)
+{
+    if (pool->freeCount == 0)
+        return CARD_NONE;
+
+    int slot = pool->freeSlots[--pool->freeCount];
+    pool->defId[slot] = (unsigned char)defId;
+    pool->power[slot] = (short)cardDefs[defId].basePower;
+    pool->flags[slot] = 0;
+    return (CardHandle)((pool->generation[slot] << 8) | slot);
+}
+
+void CardFree(CardPool *pool, CardHandle h)
+{
+    if (!CardIsAlive(pool, h))
+        return;
+
+    int slot = CardSlot(h);
+    // Generation 0 is reserved so that no live handle equals CARD_NONE
+    if (++pool->generation[slot] == 0)
+        pool->generation[slot] = 1;
+    pool->freeSlots[pool->freeCount++] = (unsigned char)slot;
+}
+
+int CardIsAlive(const CardPool *pool, CardHandle h)
+{
+    if (h == CARD_NONE || CardSlot(h) >= CARD_POOL_CAPACITY)
+        return 0;
+    return pool->generation[CardSlot(h)] == (h >> 8);
+}
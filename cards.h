@@ -0,0 +1,121 @@
+#ifndef CARDS_H
+#define CARDS_H
+
+#include <assert.h>
+
+// Card definitions and runtime card instances.
+//
+// A CardDef is the static description of a card (what is printed on it) and
+// lives in one read-only table. Every card that is actually in play - on the
+// carousel, in a row, in a hand - is an instance in a CardPool, referenced by
+// a 16-bit CardHandle. Only the handle is copied around, so changing one
+// instance's power never touches another copy of the same card.
+
+typedef enum
+{
+    CARD_NORMAL,
+    CARD_HERO,
+    CARD_WEATHER,
+    CARD_LEADER,
+    CARD_SPECIAL_UNIT
+} CardType;
+
+typedef enum
+{
+    ROW_MELEE,
+    ROW_RANGED,
+    ROW_SIEGE,
+    ROW_GLOBAL // For weather cards
+} RowType;
+
+typedef struct
+{
+    CardType type;     // Unit / Spell / Hero / Weather
+    RowType row;       // Where it can be played
+    int basePower;     // Original power
+    int isHero;        // Hero cards ignore weather
+    int isGold;        // Special status (immune sometimes)
+    const char *image; // Artwork file
+    const char *effect; // Ability spec compiled by effects.c, NULL for none
+} CardDef;
+
+#define CARD_DEF_COUNT 12
+
+extern const CardDef cardDefs[CARD_DEF_COUNT];
+
+unsigned int CardRandom(unsigned int *state);
+int CardRandomDefId(unsigned int *rng, int totalDefs);
+
+// Per-instance modifier bits
+#define CARD_FLAG_BUFFED 0x01
+#define CARD_FLAG_WEATHERED 0x02
+#define CARD_FLAG_SHIELDED 0x04
+
+#define CARD_POOL_CAPACITY 255
+
+// Low 8 bits: pool slot, high 8 bits: slot generation (never 0)
+typedef unsigned short CardHandle;
+
+#define CARD_NONE ((CardHandle)0)
+
+// Instances stored as parallel arrays so passes over one field (power sums,
+// flag sweeps) stay within a few cache lines.
+typedef struct
+{
+    unsigned char defId[CARD_POOL_CAPACITY];
+    short power[CARD_POOL_CAPACITY];
+    unsigned char flags[CARD_POOL_CAPACITY];
+    unsigned char generation[CARD_POOL_CAPACITY];
+    unsigned char freeSlots[CARD_POOL_CAPACITY];
+    int freeCount;
+} CardPool;
+
+void CardPoolInit(CardPool *pool);
+CardHandle CardSpawn(CardPool *pool, int defId);
+void CardFree(CardPool *pool, CardHandle h);
+int CardIsAlive(const CardPool *pool, CardHandle h);
+
+// Slot 255 does not exist; CardIsAlive turns such handles down, and the
+// accessors below expect a handle that has passed it
+static inline int CardSlot(CardHandle h)
+{
+    return h & 0xFF;
+}
+
+static inline const CardDef *CardDefOf(const CardPool *pool, CardHandle h)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    return &cardDefs[pool->defId[CardSlot(h)]];
+}
+
+static inline int CardDefId(const CardPool *pool, CardHandle h)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    return pool->defId[CardSlot(h)];
+}
+
+static inline int CardPower(const CardPool *pool, CardHandle h)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    return pool->power[CardSlot(h)];
+}
+
+static inline void CardSetPower(CardPool *pool, CardHandle h, int power)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    pool->power[CardSlot(h)] = (short)power;
+}
+
+static inline int CardFlags(const CardPool *pool, CardHandle h)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    return pool->flags[CardSlot(h)];
+}
+
+static inline void CardSetFlags(CardPool *pool, CardHandle h, int flags)
+{
+    assert(CardSlot(h) < CARD_POOL_CAPACITY);
+    pool->flags[CardSlot(h)] = (unsigned char)flags;
+}
+
+#endif
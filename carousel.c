@@ -0,0 +1,71 @@
+#include "carousel.h"
+#include <math.h>
+
+void CarouselInit(Carousel *c, CardPool *pool, float speed, float pitch, unsigned int seed, double now)
+{
+    c->rng = seed;
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+        c->slots[i] = CardSpawn(pool, CardRandomDefId(&c->rng, CARD_DEF_COUNT));
+    c->headSeq = 0;
+    c->scroll = 0.0;
+    c->clock = now;
+    c->speed = speed;
+    c->pitch = pitch;
+}
+
+// Restart the clock after a pause without jumping the cards forward
+void CarouselResume(Carousel *c, double now)
+{
+    c->clock = now;
+}
+
+void CarouselAdvanceTo(Carousel *c, CardPool *pool, double t)
+{
+    if (t <= c->clock)
+        return;
+
+    c->scroll += c->speed * (t - c->clock);
+    c->clock = t;
+
+    while (c->scroll - (double)c->headSeq * c->pitch > c->pitch)
+    {
+        // The top card leaves the screen unpicked
+        CardFree(pool, c->slots[0]);
+
+        // Shift queue up
+        for (int i = 0; i < CAROUSEL_SLOTS - 1; i++)
+            c->slots[i] = c->slots[i + 1];
+
+        // Add new random card at the bottom
+        c->slots[CAROUSEL_SLOTS - 1] = CardSpawn(pool, CardRandomDefId(&c->rng, CARD_DEF_COUNT));
+        c->headSeq++;
+    }
+}
+
+// Y of slots[0] relative to the top of the column, in [-pitch, 0]
+float CarouselOffset(const Carousel *c)
+{
+    return -(float)(c->scroll - (double)c->headSeq * c->pitch);
+}
+
+// Occupied slot overlapping the selection zone whose top is zoneY, or -1.
+// When two cards straddle the zone the one nearer its centre wins.
+int CarouselSlotInZone(const Carousel *c, float zoneY, float cardHeight)
+{
+    float offset = CarouselOffset(c);
+    int best = -1;
+    float bestDist = cardHeight;
+
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        if (c->slots[i] == CARD_NONE)
+            continue;
+        float dist = fabsf(offset + i * c->pitch - zoneY);
+        if (dist < bestDist)
+        {
+            bestDist = dist;
+            best = i;
+        }
+    }
+    return best;
+}
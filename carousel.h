@@ -0,0 +1,29 @@
+#ifndef CAROUSEL_H
+#define CAROUSEL_H
+
+#include "cards.h"
+
+// The scrolling card column. Its position is a pure function of time
+// (scroll = speed * elapsed), so it can be evaluated at the exact moment
+// of an input event rather than at whatever point a frame happened to draw.
+
+#define CAROUSEL_SLOTS 10
+
+typedef struct
+{
+    CardHandle slots[CAROUSEL_SLOTS]; // Top to bottom, CARD_NONE once taken
+    unsigned int headSeq;             // Cards that have left the top so far
+    double scroll;                    // Pixels scrolled since the start
+    double clock;                     // Time the scroll value belongs to
+    float speed;                      // px/sec
+    float pitch;                      // Card height + gap
+    unsigned int rng;                 // Draws for new bottom cards
+} Carousel;
+
+void CarouselInit(Carousel *c, CardPool *pool, float speed, float pitch, unsigned int seed, double now);
+void CarouselResume(Carousel *c, double now);
+void CarouselAdvanceTo(Carousel *c, CardPool *pool, double t);
+float CarouselOffset(const Carousel *c);
+int CarouselSlotInZone(const Carousel *c, float zoneY, float cardHeight);
+
+#endif
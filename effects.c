@@ -0,0 +1,516 @@
+#include "effects.h"
+#include <string.h>
+
+// Registers the compiler uses
+#define REG_SEAT 0
+#define REG_ROW 1
+#define REG_VALUE 2
+#define REG_TEST 3
+#define REG_BLOCKED 6 // + seat index within the statement: 6 self, 7 enemy
+
+#define ALL_ROWS -1
+#define WORD_MAX 16
+
+static EffectProgram programs[CARD_DEF_COUNT];
+static int effectsReady = 0;
+
+//----------------------------------------------------------------------------------
+// Compiler
+//----------------------------------------------------------------------------------
+typedef struct
+{
+    EffectProgram *out;
+    const char *p;
+    int ok;
+    int usedExposed;
+} Compiler;
+
+static void Emit(Compiler *c, int op, int a, int b, int cc)
+{
+    if (c->out->length >= EFFECT_MAX_CODE)
+    {
+        c->ok = 0;
+        return;
+    }
+    c->out->code[c->out->length++] = (EffectInsn){(unsigned char)op, (unsigned char)a, (unsigned char)b, (unsigned char)cc};
+}
+
+static void EmitImm(Compiler *c, int op, int a, int imm)
+{
+    Emit(c, op, a, imm & 0xFF, (imm >> 8) & 0xFF);
+}
+
+// Next word of the current statement into word; 0 at ';' or the end
+static int Word(Compiler *c, char word[WORD_MAX])
+{
+    while (*c->p == ' ' || *c->p == '\t')
+        c->p++;
+    int n = 0;
+    while (*c->p != '\0' && *c->p != ';' && *c->p != ' ' && *c->p != '\t')
+    {
+        if (n < WORD_MAX - 1)
+            word[n++] = *c->p;
+        c->p++;
+    }
+    word[n] = '\0';
+    return n > 0;
+}
+
+static int Number(Compiler *c)
+{
+    char word[WORD_MAX];
+    if (!Word(c, word))
+    {
+        c->ok = 0;
+        return 0;
+    }
+    int n = 0;
+    for (const char *d = word; *d; d++)
+    {
+        if (*d < '0' || *d > '9')
+            c->ok = 0;
+        n = n * 10 + (*d - '0');
+    }
+    if (n > 255)
+        c->ok = 0;
+    return n;
+}
+
+// Returns the index of the word in names, or -1
+static int Choice(Compiler *c, const char *const *names, int count)
+{
+    char word[WORD_MAX];
+    if (Word(c, word))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(word, names[i]) == 0)
+                return i;
+        }
+    }
+    c->ok = 0;
+    return -1;
+}
+
+enum
+{
+    WHO_SELF,
+    WHO_ENEMY,
+    WHO_BOTH,
+    WHO_EXPOSED
+};
+
+static int Who(Compiler *c)
+{
+    static const char *const names[] = {"self", "enemy", "both", "exposed"};
+    return Choice(c, names, 4);
+}
+
+static int Row(Compiler *c)
+{
+    static const char *const names[] = {"melee", "ranged", "siege", "own", "all"};
+    int row = Choice(c, names, 5);
+    if (row == 3)
+        return ROW_GLOBAL; // Stands for the card's own row until run time
+    if (row == 4)
+        return ALL_ROWS;
+    return row;
+}
+
+// One row operation for the seat in REG_SEAT, REG_VALUE already loaded
+static int EmitRows(Compiler *c, int op, int row)
+{
+    int start = c->out->length;
+    for (int r = 0; r < MATCH_ROWS; r++)
+    {
+        if (row != ALL_ROWS && row != r && row != ROW_GLOBAL)
+            continue;
+        if (row == ROW_GLOBAL)
+            Emit(c, EFFECT_OWN_ROW, REG_ROW, 0, 0);
+        else
+            EmitImm(c, EFFECT_LOADI, REG_ROW, r);
+        Emit(c, op, REG_SEAT, REG_ROW, REG_VALUE);
+        if (row == ROW_GLOBAL)
+            break;
+    }
+    return c->out->length - start;
+}
+
+// The row operation for every seat `who` covers. Exposed seats are tested
+// for a shield at run time and skipped, noting the block, if one is up.
+static void EmitTargets(Compiler *c, int op, int who, int row)
+{
+    for (int i = 0; i < MATCH_PLAYERS; i++)
+    {
+        if ((who == WHO_SELF && i != 0) || (who == WHO_ENEMY && i != 1))
+            continue;
+        Emit(c, i == 0 ? EFFECT_SELF : EFFECT_ENEMY, REG_SEAT, 0, 0);
+        if (who != WHO_EXPOSED)
+        {
+            EmitRows(c, op, row);
+            continue;
+        }
+
+        c->usedExposed = 1;
+        Emit(c, EFFECT_SHIELDED, REG_TEST, REG_SEAT, 0);
+        EmitImm(c, EFFECT_JZ, REG_TEST, 2);
+        EmitImm(c, EFFECT_LOADI, REG_BLOCKED + i, 1);
+        int jump = c->out->length;
+        EmitImm(c, EFFECT_JMP, 0, 0);
+        int length = EmitRows(c, op, row);
+        if (c->ok)
+            c->out->code[jump] = (EffectInsn){EFFECT_JMP, 0, (unsigned char)(length & 0xFF), (unsigned char)(length >> 8)};
+    }
+}
+
+// After a weather statement, what the program does to exposed units is what
+// the weather keeps doing to units placed later
+static void Linger(Compiler *c, int op, int who, int row, int value)
+{
+    if (c->out->weather == 0 || who != WHO_EXPOSED || row == ROW_GLOBAL)
+        return;
+    c->out->lingerOp = (unsigned char)op;
+    c->out->lingerRow = (signed char)row;
+    c->out->lingerValue = (unsigned char)value;
+}
+
+static void Statement(Compiler *c)
+{
+    static const char *const verbs[] = {"add", "set", "halve", "shield", "steal", "weather"};
+    int verb = Choice(c, verbs, 6);
+    switch (verb)
+    {
+    case 0: // add
+    case 1: // set
+    {
+        int who = Who(c);
+        int row = Row(c);
+        int value = Number(c);
+        EmitImm(c, EFFECT_LOADI, REG_VALUE, value);
+        EmitTargets(c, verb == 0 ? EFFECT_ADD_ROW : EFFECT_SET_ROW, who, row);
+        Linger(c, verb == 0 ? EFFECT_ADD_ROW : EFFECT_SET_ROW, who, row, value);
+        break;
+    }
+    case 2: // halve
+    {
+        int who = Who(c);
+        int row = Row(c);
+        EmitTargets(c, EFFECT_HALVE_ROW, who, row);
+        Linger(c, EFFECT_HALVE_ROW, who, row, 0);
+        break;
+    }
+    case 3: // shield
+    {
+        int who = Who(c);
+        if (who == WHO_EXPOSED)
+            c->ok = 0;
+        if (who != WHO_ENEMY)
+        {
+            Emit(c, EFFECT_SELF, REG_SEAT, 0, 0);
+            Emit(c, EFFECT_SHIELD, REG_SEAT, 0, 0);
+        }
+        if (who == WHO_ENEMY || who == WHO_BOTH)
+        {
+            Emit(c, EFFECT_ENEMY, REG_SEAT, 0, 0);
+            Emit(c, EFFECT_SHIELD, REG_SEAT, 0, 0);
+        }
+        break;
+    }
+    case 4: // steal
+        EmitImm(c, EFFECT_LOADI, REG_VALUE, Number(c));
+        Emit(c, EFFECT_STEAL, REG_TEST, REG_VALUE, 0);
+        break;
+    case 5: // weather
+    {
+        static const char *const kinds[] = {"frost", "fog", "storm"};
+        static const int bits[] = {WEATHER_FROST, WEATHER_FOG, WEATHER_STORM};
+        int kind = Choice(c, kinds, 3);
+        if (kind >= 0)
+        {
+            Emit(c, EFFECT_WEATHER, bits[kind], 0, 0);
+            c->out->weather |= (unsigned char)bits[kind];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    // Anything left before the ';' is a mistake
+    char extra[WORD_MAX];
+    if (Word(c, extra))
+        c->ok = 0;
+}
+
+// Returns 1 on success. An empty or NULL spec compiles to no program.
+int EffectCompile(const char *spec, EffectProgram *out)
+{
+    Compiler c = {out, spec != NULL ? spec : "", 1, 0};
+    memset(out, 0, sizeof(*out));
+
+    while (c.ok)
+    {
+        while (*c.p == ' ' || *c.p == '\t' || *c.p == ';')
+            c.p++;
+        if (*c.p == '\0')
+            break;
+        Statement(&c);
+    }
+    if (c.ok && out->length == 0)
+        return 1;
+
+    // Shields that blocked something are used up once, however many
+    // statements they blocked
+    if (c.usedExposed)
+    {
+        for (int i = 0; i < MATCH_PLAYERS; i++)
+        {
+            Emit(&c, i == 0 ? EFFECT_SELF : EFFECT_ENEMY, REG_SEAT, 0, 0);
+            EmitImm(&c, EFFECT_JZ, REG_BLOCKED + i, 1);
+            Emit(&c, EFFECT_UNSHIELD, REG_SEAT, 0, 0);
+        }
+    }
+    Emit(&c, EFFECT_END, 0, 0, 0);
+
+    if (!c.ok)
+        memset(out, 0, sizeof(*out));
+    return c.ok;
+}
+
+int EffectInit(void)
+{
+    if (effectsReady)
+        return 0;
+    int failed = 0;
+    for (int i = 0; i < CARD_DEF_COUNT; i++)
+    {
+        if (!EffectCompile(cardDefs[i].effect, &programs[i]))
+            failed++;
+    }
+    effectsReady = 1;
+    return failed;
+}
+
+const EffectProgram *EffectProgramOf(int defId)
+{
+    if (defId < 0 || defId >= CARD_DEF_COUNT || programs[defId].length == 0)
+        return NULL;
+    return &programs[defId];
+}
+
+//----------------------------------------------------------------------------------
+// Interpreter
+//----------------------------------------------------------------------------------
+
+// Board and instance power move together; the card is flagged buffed or
+// weathered by which way its power actually went
+static void SetUnit(MatchState *m, int seat, int row, int slot, int power)
+{
+    int before = m->board.power[seat][row][slot];
+    BoardSetPower(&m->board, &m->hash, seat, row, slot, power);
+    int after = m->board.power[seat][row][slot];
+    CardHandle card = m->rows[seat][row][slot];
+    if (card != CARD_NONE)
+    {
+        CardSetPower(&m->pool, card, after);
+        if (after != before)
+            CardSetFlags(&m->pool, card,
+                         CardFlags(&m->pool, card) | (after > before ? CARD_FLAG_BUFFED : CARD_FLAG_WEATHERED));
+    }
+}
+
+static unsigned int Units(const MatchState *m, int seat, int row)
+{
+    return m->board.occupied[seat][row] & ~m->board.hero[seat][row];
+}
+
+typedef enum
+{
+    UNIT_ADD,
+    UNIT_SET,
+    UNIT_HALVE
+} UnitChange;
+
+static void ChangeUnit(MatchState *m, int seat, int row, int slot, UnitChange change, int value)
+{
+    int power = m->board.power[seat][row][slot];
+    if (change == UNIT_ADD)
+        SetUnit(m, seat, row, slot, power + value);
+    else if (change == UNIT_SET)
+        SetUnit(m, seat, row, slot, value);
+    else
+        SetUnit(m, seat, row, slot, power / 2);
+}
+
+static void ChangeRow(MatchState *m, int seat, int row, UnitChange change, int value)
+{
+    if ((unsigned)seat >= MATCH_PLAYERS || (unsigned)row >= MATCH_ROWS)
+        return;
+    for (unsigned int units = Units(m, seat, row); units; units &= units - 1)
+    {
+        ChangeUnit(m, seat, row, __builtin_ctz(units), change, value);
+    }
+}
+
+void EffectWeatherPlaced(MatchState *m, int seat, int row, int slot)
+{
+    unsigned int weather = m->board.flags & BOARD_WEATHER_MASK;
+    if (weather == 0 || (m->board.flags & BOARD_SHIELD(seat)) || !(Units(m, seat, row) & (1u << slot)))
+        return;
+    for (int d = 0; d < CARD_DEF_COUNT; d++)
+    {
+        const EffectProgram *p = &programs[d];
+        if (!(p->weather & weather) || p->lingerOp == 0 || (p->lingerRow != ALL_ROWS && p->lingerRow != row))
+            continue;
+        UnitChange change = p->lingerOp == EFFECT_ADD_ROW ? UNIT_ADD : p->lingerOp == EFFECT_SET_ROW ? UNIT_SET : UNIT_HALVE;
+        ChangeUnit(m, seat, row, slot, change, p->lingerValue);
+    }
+}
+
+// Strongest non-hero unit of a seat as row * MAX_ROW_CARDS + slot, or -1
+static int Strongest(const MatchState *m, int seat)
+{
+    int best = -1, bestPower = -1;
+    for (int row = 0; row < MATCH_ROWS; row++)
+    {
+        for (unsigned int units = Units(m, seat, row); units; units &= units - 1)
+        {
+            int slot = __builtin_ctz(units);
+            if (m->board.power[seat][row][slot] > bestPower)
+            {
+                bestPower = m->board.power[seat][row][slot];
+                best = row * MAX_ROW_CARDS + slot;
+            }
+        }
+    }
+    return best;
+}
+
+static int Steal(MatchState *m, int player, int amount)
+{
+    int enemy = 1 - player;
+    int from = Strongest(m, enemy);
+    if (from < 0 || amount <= 0)
+        return 0;
+    int row = from / MAX_ROW_CARDS, slot = from % MAX_ROW_CARDS;
+    int power = m->board.power[enemy][row][slot];
+    int taken = amount < power ? amount : power;
+    SetUnit(m, enemy, row, slot, power - taken);
+
+    int to = Strongest(m, player);
+    if (to >= 0)
+    {
+        row = to / MAX_ROW_CARDS;
+        slot = to % MAX_ROW_CARDS;
+        SetUnit(m, player, row, slot, m->board.power[player][row][slot] + taken);
+    }
+    return taken;
+}
+
+// Run a card's program for `player`, who put the card in `row` (ROW_GLOBAL
+// for cards that do not stay on the board). Returns 1 if it ran to the end,
+// 0 if it was stopped for a bad instruction or too many steps.
+int EffectRun(const EffectProgram *p, MatchState *m, int player, int row)
+{
+    int r[EFFECT_REGISTERS] = {0};
+    const EffectInsn *code = p->code;
+    const EffectInsn *end = code + p->length;
+    const EffectInsn *in = code;
+    int steps = 0;
+
+#define IMM(i) ((short)((i)->b | ((i)->c << 8)))
+#define REG(x) r[(x) & (EFFECT_REGISTERS - 1)]
+
+#if defined(__GNUC__)
+    // Jump table of label addresses: one indirect branch per instruction
+    static void *const ops[EFFECT_OP_COUNT] = {
+        &&op_end,      &&op_loadi,  &&op_self,     &&op_enemy,   &&op_own_row, &&op_add_row,
+        &&op_set_row,  &&op_halve,  &&op_shielded, &&op_shield,  &&op_unshield, &&op_weather,
+        &&op_steal,    &&op_jz,     &&op_jnz,      &&op_jmp};
+#define CASE(label, op) label:
+#define NEXT                                                                                                           \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        in++;                                                                                                          \
+        goto dispatch;                                                                                                 \
+    } while (0)
+dispatch:
+    if (in < code || in >= end || in->op >= EFFECT_OP_COUNT || ++steps > EFFECT_MAX_STEPS)
+        return 0;
+    goto *ops[in->op];
+#else
+#define CASE(label, op) case op:
+#define NEXT                                                                                                           \
+    in++;                                                                                                              \
+    continue
+    for (;;)
+    {
+        if (in < code || in >= end || ++steps > EFFECT_MAX_STEPS)
+            return 0;
+        switch (in->op)
+        {
+        default:
+            return 0;
+#endif
+
+    CASE(op_end, EFFECT_END)
+        return 1;
+    CASE(op_loadi, EFFECT_LOADI)
+        REG(in->a) = IMM(in);
+        NEXT;
+    CASE(op_self, EFFECT_SELF)
+        REG(in->a) = player;
+        NEXT;
+    CASE(op_enemy, EFFECT_ENEMY)
+        REG(in->a) = 1 - player;
+        NEXT;
+    CASE(op_own_row, EFFECT_OWN_ROW)
+        REG(in->a) = row;
+        NEXT;
+    CASE(op_add_row, EFFECT_ADD_ROW)
+        ChangeRow(m, REG(in->a), REG(in->b), UNIT_ADD, REG(in->c));
+        NEXT;
+    CASE(op_set_row, EFFECT_SET_ROW)
+        ChangeRow(m, REG(in->a), REG(in->b), UNIT_SET, REG(in->c));
+        NEXT;
+    CASE(op_halve, EFFECT_HALVE_ROW)
+        ChangeRow(m, REG(in->a), REG(in->b), UNIT_HALVE, 0);
+        NEXT;
+    CASE(op_shielded, EFFECT_SHIELDED)
+        REG(in->a) = (unsigned)REG(in->b) < MATCH_PLAYERS && (m->board.flags & BOARD_SHIELD(REG(in->b))) != 0;
+        NEXT;
+    CASE(op_shield, EFFECT_SHIELD)
+        if ((unsigned)REG(in->a) < MATCH_PLAYERS)
+            BoardSetFlags(&m->board, &m->hash, m->board.flags | BOARD_SHIELD(REG(in->a)));
+        NEXT;
+    CASE(op_unshield, EFFECT_UNSHIELD)
+        if ((unsigned)REG(in->a) < MATCH_PLAYERS)
+            BoardSetFlags(&m->board, &m->hash, m->board.flags & ~BOARD_SHIELD(REG(in->a)));
+        NEXT;
+    CASE(op_weather, EFFECT_WEATHER)
+        BoardSetFlags(&m->board, &m->hash, m->board.flags | (in->a & BOARD_WEATHER_MASK));
+        NEXT;
+    CASE(op_steal, EFFECT_STEAL)
+        REG(in->a) = Steal(m, player, REG(in->b));
+        NEXT;
+    CASE(op_jz, EFFECT_JZ)
+        if (REG(in->a) == 0)
+            in += IMM(in);
+        NEXT;
+    CASE(op_jnz, EFFECT_JNZ)
+        if (REG(in->a) != 0)
+            in += IMM(in);
+        NEXT;
+    CASE(op_jmp, EFFECT_JMP)
+        in += IMM(in);
+        NEXT;
+
+#if !defined(__GNUC__)
+        }
+    }
+#endif
+#undef CASE
+#undef NEXT
+#undef IMM
+#undef REG
+}
@@ -0,0 +1,79 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "match.h"
+
+// Card abilities as bytecode. Each CardDef carries a short effect spec in
+// plain text; EffectInit compiles every spec once into instructions for a
+// small register machine, and MatchPlayCard runs the program of each card
+// played. A new card made from the existing verbs needs only its spec.
+//
+// Spec statements, separated by ';':
+//   add <who> <row> <n>   add n to each non-hero unit
+//   set <who> <row> <n>   set each non-hero unit to n
+//   halve <who> <row>     halve each non-hero unit, rounding down
+//   shield <who>          block the next weather aimed at that side
+//   steal <n>             move up to n points from the enemy's strongest
+//                         non-hero unit to the player's strongest
+//   weather <frost|fog|storm>
+//
+// <who> is self, enemy, both or exposed - each side that has no shield up; a
+// shield that blocks anything is used up when the program ends. <row> is
+// melee, ranged, siege, own (the card's row) or all.
+
+#define EFFECT_REGISTERS 8
+#define EFFECT_MAX_CODE 96
+#define EFFECT_MAX_STEPS 1024 // Instructions one run may execute
+
+typedef enum
+{
+    EFFECT_END,       //                        stop
+    EFFECT_LOADI,     // a, imm16 in b|c<<8     r[a] = imm
+    EFFECT_SELF,      // a                      r[a] = playing seat
+    EFFECT_ENEMY,     // a                      r[a] = other seat
+    EFFECT_OWN_ROW,   // a                      r[a] = row the card went to
+    EFFECT_ADD_ROW,   // seat, row, amount      non-hero units += r[amount]
+    EFFECT_SET_ROW,   // seat, row, value       non-hero units = r[value]
+    EFFECT_HALVE_ROW, // seat, row              non-hero units /= 2
+    EFFECT_SHIELDED,  // a, seat                r[a] = seat has a shield up
+    EFFECT_SHIELD,    // seat                   raise the seat's shield
+    EFFECT_UNSHIELD,  // seat                   drop it
+    EFFECT_WEATHER,   // bits                   WEATHER_* bits now in play
+    EFFECT_STEAL,     // a, amount              r[a] = points actually moved
+    EFFECT_JZ,        // a, off16 in b|c<<8     if r[a] == 0, skip off instructions
+    EFFECT_JNZ,       // a, off16 in b|c<<8     if r[a] != 0, skip off instructions
+    EFFECT_JMP,       // off16 in b|c<<8        skip off instructions
+    EFFECT_OP_COUNT
+} EffectOp;
+
+typedef struct
+{
+    unsigned char op;
+    unsigned char a;
+    unsigned char b;
+    unsigned char c;
+} EffectInsn;
+
+// A weather card's program also records what its weather does to exposed
+// units, so units placed while it is still in play get the same treatment
+typedef struct
+{
+    EffectInsn code[EFFECT_MAX_CODE];
+    int length; // 0 = no effect
+
+    unsigned char weather;     // WEATHER_* bits the program sets, 0 if none
+    unsigned char lingerOp;    // EFFECT_ADD_ROW/SET_ROW/HALVE_ROW it applies to exposed units, 0 if none
+    signed char lingerRow;     // Row that hits, -1 for all
+    unsigned char lingerValue; // Amount for add and set
+} EffectProgram;
+
+// Compiles every card's spec; returns how many failed. Call once at program
+// start, before any match runs: matches may run on other threads.
+int EffectInit(void);
+int EffectCompile(const char *spec, EffectProgram *out);
+const EffectProgram *EffectProgramOf(int defId); // NULL if the card has no effect
+int EffectRun(const EffectProgram *p, MatchState *m, int player, int row);
+// Weather in play hits a unit just placed in the row, unless its side is shielded
+void EffectWeatherPlaced(MatchState *m, int seat, int row, int slot);
+
+#endif
@@ -0,0 +1,154 @@
+#include "input.h"
+#include "raylib.h"
+#include <stdlib.h>
+#include <string.h>
+
+void InputInit(InputQueue *q, const int *keys, int keyCount)
+{
+    memset(q, 0, sizeof(*q));
+    if (keyCount > INPUT_MAX_KEYS)
+        keyCount = INPUT_MAX_KEYS;
+    memcpy(q->keys, keys, keyCount * sizeof(int));
+    q->keyCount = keyCount;
+}
+
+void InputLatchKeys(InputQueue *q, const int *keys, int keyCount)
+{
+    if (keyCount > INPUT_MAX_LATCH)
+        keyCount = INPUT_MAX_LATCH;
+    memcpy(q->latchKeys, keys, keyCount * sizeof(int));
+    q->latchCount = keyCount;
+    q->latched = 0;
+}
+
+// Queue the presses raylib saw in its last poll, stamped with `now`, and
+// latch the edges the frame reads later
+void InputSample(InputQueue *q, double now)
+{
+    for (int k = 0; k < q->latchCount; k++)
+    {
+        if (IsKeyPressed(q->latchKeys[k]))
+            q->latched |= 1u << k;
+    }
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+        q->clicked = 1;
+
+    for (int k = 0; k < q->keyCount; k++)
+    {
+        if (!IsKeyPressed(q->keys[k]))
+            continue;
+        if (q->count == INPUT_QUEUE_SIZE)
+        {
+            // Drop the oldest press rather than the newest
+            q->head = (q->head + 1) % INPUT_QUEUE_SIZE;
+            q->count--;
+        }
+        InputEvent *e = &q->events[(q->head + q->count) % INPUT_QUEUE_SIZE];
+        e->time = now;
+        e->key = q->keys[k];
+        q->count++;
+    }
+}
+
+// Late latching: keep polling until the next frame is due instead of
+// sleeping through it. Only valid when raylib leaves polling to us.
+void InputWaitAndPoll(InputQueue *q, double deadline)
+{
+    do
+    {
+        PollInputEvents();
+        InputSample(q, GetTime());
+        if (GetTime() + INPUT_POLL_INTERVAL < deadline)
+            WaitTime(INPUT_POLL_INTERVAL);
+    } while (GetTime() < deadline);
+}
+
+int InputPop(InputQueue *q, InputEvent *out)
+{
+    if (q->count == 0)
+        return 0;
+    *out = q->events[q->head];
+    q->head = (q->head + 1) % INPUT_QUEUE_SIZE;
+    q->count--;
+    return 1;
+}
+
+int InputKeyPressed(const InputQueue *q, int key)
+{
+    for (int k = 0; k < q->latchCount; k++)
+    {
+        if (q->latchKeys[k] == key)
+            return (q->latched >> k) & 1;
+    }
+    return 0;
+}
+
+int InputClicked(const InputQueue *q)
+{
+    return q->clicked;
+}
+
+// Once the frame has read everything it needs
+void InputClearLatched(InputQueue *q)
+{
+    q->latched = 0;
+    q->clicked = 0;
+}
+
+void InputLatencyInit(InputLatency *lat)
+{
+    memset(lat, 0, sizeof(*lat));
+    lat->pending = -1.0;
+}
+
+// A press changed the game; its latency ends when that frame is presented
+void InputLatencyPress(InputLatency *lat, double pressTime)
+{
+    if (lat->pending < 0.0)
+        lat->pending = pressTime;
+}
+
+// Call right after the buffer swap. This measures press-to-swap; the
+// display adds its own scanout delay on top.
+void InputLatencyPresented(InputLatency *lat, double now)
+{
+    if (lat->pending < 0.0)
+        return;
+
+    float sample = (float)(now - lat->pending);
+    lat->pending = -1.0;
+
+    lat->samples[lat->next] = sample;
+    lat->next = (lat->next + 1) % INPUT_LATENCY_SAMPLES;
+    if (lat->count < INPUT_LATENCY_SAMPLES)
+        lat->count++;
+    if (sample > lat->max)
+        lat->max = sample;
+}
+
+static int CompareFloat(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+InputLatencyReport InputLatencyGetReport(const InputLatency *lat)
+{
+    InputLatencyReport r = {0};
+    if (lat->count == 0)
+        return r;
+
+    float sorted[INPUT_LATENCY_SAMPLES];
+    float sum = 0.0f;
+    memcpy(sorted, lat->samples, lat->count * sizeof(float));
+    for (int i = 0; i < lat->count; i++)
+        sum += sorted[i];
+    qsort(sorted, lat->count, sizeof(float), CompareFloat);
+
+    r.avg = sum / lat->count;
+    r.p99 = sorted[(lat->count * 99) / 100];
+    r.max = lat->max;
+    r.count = lat->count;
+    return r;
+}
@@ -0,0 +1,72 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+// Timestamped key presses and press-to-display latency tracking.
+//
+// Presses are queued with the time they were polled so gameplay can resolve
+// them against the state at that instant. With GOWTHER_LATE_LATCH defined
+// (needs raylib built with SUPPORT_CUSTOM_FRAME_CONTROL) the end-of-frame
+// sleep is replaced by a polling loop, which both sharpens the timestamps to
+// about a millisecond and samples input right before the next frame is built.
+//
+// Every poll moves raylib's pressed edges on, so keys the frame only needs to
+// see once (menus, toggles) and the mouse click are latched as well: each
+// sample ORs them in, and the frame reads and clears them.
+
+#define INPUT_QUEUE_SIZE 32
+#define INPUT_MAX_KEYS 8
+#define INPUT_MAX_LATCH 16
+#define INPUT_LATENCY_SAMPLES 256
+#define INPUT_POLL_INTERVAL 0.0005 // seconds between polls while late latching
+
+typedef struct
+{
+    double time; // GetTime() when the press was polled
+    int key;
+} InputEvent;
+
+typedef struct
+{
+    InputEvent events[INPUT_QUEUE_SIZE]; // Ring buffer, oldest at head
+    int head;
+    int count;
+    int keys[INPUT_MAX_KEYS]; // Keys worth timestamping
+    int keyCount;
+    int latchKeys[INPUT_MAX_LATCH]; // Keys the frame only asks "pressed?" about
+    int latchCount;
+    unsigned int latched; // Bit per latch key pressed since the last clear
+    int clicked;          // Left button went down since the last clear
+} InputQueue;
+
+typedef struct
+{
+    float samples[INPUT_LATENCY_SAMPLES]; // Seconds, ring buffer
+    int next;
+    int count;
+    double pending; // Press time waiting for its first displayed frame, < 0 if none
+    float max;
+} InputLatency;
+
+typedef struct
+{
+    float avg;
+    float p99;
+    float max;
+    int count;
+} InputLatencyReport;
+
+void InputInit(InputQueue *q, const int *keys, int keyCount);
+void InputLatchKeys(InputQueue *q, const int *keys, int keyCount);
+void InputSample(InputQueue *q, double now);
+void InputWaitAndPoll(InputQueue *q, double deadline);
+int InputPop(InputQueue *q, InputEvent *out);
+int InputKeyPressed(const InputQueue *q, int key);
+int InputClicked(const InputQueue *q);
+void InputClearLatched(InputQueue *q);
+
+void InputLatencyInit(InputLatency *lat);
+void InputLatencyPress(InputLatency *lat, double pressTime);
+void InputLatencyPresented(InputLatency *lat, double now);
+InputLatencyReport InputLatencyGetReport(const InputLatency *lat);
+
+#endif
@@ -1,345 +1,729 @@
 #include "raylib.h"
-#include <time.h>
+#include "resources.h"
+#include "cards.h"
+#include "match.h"
+#include "matchview.h"
+#include "boardview.h"
+#include "render.h"
+#include "input.h"
+#include "telemetry.h"
+#include "capture.h"
+#include "effects.h"
+#include "stats.h"
+#include "replay.h"
+#include "bench.h"
+#include "boardwall.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
-#define MAX_CARDS 10
 #define GAP 10
-#define MAX_ROW_CARDS 8 // per row
+#define MEMORY_BUDGET (192 * 1024 * 1024) // CPU + GPU bytes held through the registry
+#define RECENT_SESSIONS 10
 
-typedef enum
+enum GameState
 {
-    CARD_NORMAL,
-    CARD_HERO,
-    CARD_WEATHER,
-    CARD_LEADER,
-    CARD_SPECIAL_UNIT
-} CardType;
-
-typedef enum
+    MENU,
+    PLAY,
+    HELP,
+    STATS,
+    EXIT
+};
+
+// Sprites beyond the board's own
+enum
 {
-    ROW_MELEE,
-    ROW_RANGED,
-    ROW_SIEGE,
-    ROW_GLOBAL // For weather cards
-} RowType;
+    SPRITE_MENU_BG = SPRITE_BOARD_COUNT,
+    SPRITE_BUTTONS,
+    SPRITE_COUNT
+};
 
+// Menu and stats screen layers, bottom to top
+enum
+{
+    LAYER_MENU_BG,
+    LAYER_MENU_BUTTONS,
+    LAYER_MENU_TEXT
+};
+
+// Everything the update owns. It runs on the render pipeline's worker, so the
+// main thread fills in the frame input and reads the results only while the
+// worker is idle, between RenderPipelineWait and RenderPipelineKick.
 typedef struct
 {
-    CardType type;    // Unit / Spell / Hero / Weather
-    RowType row;      // Where it can be played
-    int basePower;    // Original power
-    int currentPower; // Modified power after buffs/debuffs
-    int isHero;       // Hero cards ignore weather
-    int isGold;       // Special status (immune sometimes)
-    Texture2D normTex;
-    Texture2D rotatedTex; // Card artwork
-} Card;
-
-static Card CreateCard(CardType type, RowType row, int basePower, Image img, int hero, int gold)
+    // Frame input
+    double now;
+    Vector2 mouse;
+    int click;
+    int back;
+    InputEvent presses[INPUT_QUEUE_SIZE];
+    int pressCount;
+
+    // Results
+    double accepted[INPUT_QUEUE_SIZE]; // Times of the presses that picked a card
+    int acceptedCount;
+
+    int state;
+    MatchConfig config;
+    MatchState match; // Set up when PLAY is pressed
+    MatchView view;
+    int statPlayers[MATCH_PLAYERS];
+    char cardNames[CARD_DEF_COUNT][32];
+    unsigned int seed; // Of the next match
+    Rectangle btnPlay;
+    Rectangle btnStats;
+    Rectangle btnQuit;
+} Game;
+
+// Adds the game to the stats store. Only a match that ran to its end between
+// two known players counts as one; anything else - the single-seat game, or
+// a match left early - is a session for the first seat.
+static void RecordMatch(const MatchState *m, const int players[MATCH_PLAYERS], double now)
+{
+    if (!m->over || players[1] < 0)
+    {
+        StatsSessionResult session = {0};
+        session.player = players[0];
+        session.total = MatchTotal(m, 0);
+        session.duration = (int)(now - m->startTime);
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            for (int i = 0; i < MAX_ROW_CARDS && m->rows[0][r][i] != CARD_NONE; i++)
+                session.picks[CardDefId(&m->pool, m->rows[0][r][i])]++;
+        }
+        StatsRecordSession(&session);
+        return;
+    }
+
+    StatsMatchResult result = {0};
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        result.players[s] = players[s];
+        result.totals[s] = MatchTotal(m, s);
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            for (int i = 0; i < MAX_ROW_CARDS && m->rows[s][r][i] != CARD_NONE; i++)
+                result.picks[s][CardDefId(&m->pool, m->rows[s][r][i])]++;
+        }
+    }
+    result.winner = MatchWinner(m);
+    result.duration = (int)(now - m->startTime);
+    StatsRecordMatch(&result);
+}
+
+static void RenderButton(RenderList *list, Rectangle btn, const char *label, int labelX, Vector2 mouse)
+{
+    RenderSprite(list, LAYER_MENU_BUTTONS, SPRITE_BUTTONS, btn.x, btn.y, WHITE);
+    RenderText(list, LAYER_MENU_TEXT, btn.x + labelX, btn.y + 42, 30,
+               CheckCollisionPointRec(mouse, btn) ? YELLOW : WHITE, "%s", label);
+}
+
+// The local player's sessions and card picks. The game has one seat, so it
+// never writes two-seat matches and the leaderboard has nothing to show.
+static void RenderStatsScreen(RenderList *list, const Game *g)
+{
+    RenderSprite(list, LAYER_MENU_BG, SPRITE_MENU_BG, 0, 0, Fade(WHITE, 0.3f));
+
+    const StatsProfile *me = StatsGetProfile(g->statPlayers[0]);
+    if (me != NULL)
+    {
+        RenderText(list, LAYER_MENU_TEXT, 60, 40, 30, RAYWHITE, "%s", me->name);
+        RenderText(list, LAYER_MENU_TEXT, 60, 80, 20, RAYWHITE, "%u sessions  best %u  total %llu  average %.1f",
+                   me->sessions, me->sessionBest, me->sessionScore,
+                   me->sessions > 0 ? (double)me->sessionScore / me->sessions : 0.0);
+    }
+
+    RenderText(list, LAYER_MENU_TEXT, 60, 130, 20, YELLOW, "Cards");
+    for (int d = 0; d < CARD_DEF_COUNT; d++)
+    {
+        const StatsCard *c = StatsCardStats(d);
+        if (c == NULL)
+            break;
+        if (c->matchPicks > 0)
+            RenderText(list, LAYER_MENU_TEXT, 60, 160 + d * 24, 20, RAYWHITE,
+                       "%-12s %6llu picks  %3.0f%% of match picks won", g->cardNames[d], c->picks,
+                       100.0 * c->wins / c->matchPicks);
+        else
+            RenderText(list, LAYER_MENU_TEXT, 60, 160 + d * 24, 20, RAYWHITE, "%-12s %6llu picks", g->cardNames[d],
+                       c->picks);
+    }
+
+    const StatsRecord *recent[RECENT_SESSIONS];
+    int n = StatsRecentSessions(recent, RECENT_SESSIONS);
+    RenderText(list, LAYER_MENU_TEXT, 720, 130, 20, YELLOW, "Recent sessions");
+    for (int i = 0; i < n; i++)
+    {
+        const StatsRecord *r = recent[i];
+        RenderText(list, LAYER_MENU_TEXT, 720, 160 + i * 24, 20, RAYWHITE, "%4u points  %d:%02d", r->as.match.totals[0],
+                   r->duration / 60, r->duration % 60);
+    }
+    RenderText(list, LAYER_MENU_TEXT, 60, VIEW_HEIGHT - 40, 20, GRAY, "BACKSPACE to return");
+}
+
+// One frame of game logic, drawn into a render list. No GL calls and no
+// raylib input polling: everything it reads from outside is in the frame input.
+static void GameUpdate(void *user, RenderList *out)
 {
-    Card c;
-    c.type = type;
-    c.row = row;
-    c.basePower = basePower;
-    c.currentPower = basePower;
-    c.isHero = hero;
-    c.isGold = gold;
-
-    // Normal texture
-    c.normTex = LoadTextureFromImage(img);
-
-    // Rotated texture
-    Image temp = ImageCopy(img);
-    ImageRotateCW(&temp);
-    c.rotatedTex = LoadTextureFromImage(temp);
-    UnloadImage(temp);
-
-    return c;
+    Game *g = user;
+    g->acceptedCount = 0;
+
+    // Input
+    if (g->state == MENU)
+    {
+        if (g->click && CheckCollisionPointRec(g->mouse, g->btnPlay))
+            g->state = PLAY;
+        if (g->click && CheckCollisionPointRec(g->mouse, g->btnStats))
+            g->state = STATS;
+        if (g->click && CheckCollisionPointRec(g->mouse, g->btnQuit))
+            g->state = EXIT;
+        if (g->state == PLAY)
+            MatchInit(&g->match, &g->config, g->seed++, g->now);
+    }
+    else if (g->back && (g->state == PLAY || g->state == STATS))
+    {
+        // Leaving is recorded too, as a session
+        if (g->state == PLAY)
+            RecordMatch(&g->match, g->statPlayers, g->now);
+        g->state = MENU;
+    }
+
+    // Update
+    for (int i = 0; i < g->pressCount; i++)
+    {
+        // Resolved against where the carousel was when the key went down
+        if (g->state == PLAY && MatchPick(&g->match, 0, g->presses[i].time) != -1)
+            g->accepted[g->acceptedCount++] = g->presses[i].time;
+    }
+    if (g->state == PLAY)
+        MatchTick(&g->match, g->now);
+
+    // Draw
+    if (g->state == MENU)
+    {
+        RenderSprite(out, LAYER_MENU_BG, SPRITE_MENU_BG, 0, 0, WHITE);
+        RenderButton(out, g->btnPlay, "PLAY", 65, g->mouse);
+        RenderButton(out, g->btnStats, "STATS", 58, g->mouse);
+        RenderButton(out, g->btnQuit, "Quit", 65, g->mouse);
+    }
+    else if (g->state == STATS)
+    {
+        RenderStatsScreen(out, g);
+    }
+    else if (g->state == PLAY)
+    {
+        MatchViewCapture(&g->view, &g->match, 0, g->now);
+        RenderMatchView(out, &g->view);
+    }
 }
 
-int GetRandomCardIndex(Card *cards, int totalCards)
+// Frame input from the devices, or from the recording being played back.
+// Returns 0 when the recording has run out.
+static int GameSetInput(Game *g, InputQueue *input, double now, int replaying)
 {
-    int r = rand() % 100;
-    CardType chosenType;
-    if (r >= 0 && r <= 70)
-        chosenType = CARD_NORMAL;
-    else if (r > 70 && r <= 80)
-        chosenType = CARD_WEATHER;
-    else if (r > 80 && r <= 90)
-        chosenType = CARD_SPECIAL_UNIT;
+    ReplayFrame f;
+    if (replaying)
+    {
+        if (!ReplayNextFrame(&f))
+            return 0;
+    }
     else
-        chosenType = CARD_HERO;
+    {
+        f.now = now;
+        f.mouseX = GetMousePosition().x;
+        f.mouseY = GetMousePosition().y;
+        f.click = InputClicked(input);
+        f.back = InputKeyPressed(input, KEY_BACKSPACE);
+        f.pressCount = 0;
+        while (f.pressCount < INPUT_QUEUE_SIZE && InputPop(input, &f.presses[f.pressCount]))
+            f.pressCount++;
+        ReplayRecordFrame(&f);
+    }
+
+    g->now = f.now;
+    g->mouse = (Vector2){f.mouseX, f.mouseY};
+    g->click = f.click;
+    g->back = f.back;
+    g->pressCount = f.pressCount;
+    memcpy(g->presses, f.presses, f.pressCount * sizeof(InputEvent));
+    return 1;
+}
 
-    int idx = -1;
-    while (idx == -1)
+// Command line:
+//   --record <file>     record this session for playback
+//   --replay <file>     play a recorded session back as fast as possible
+//   --bench-out <file>  with --replay: write frame-time and memory results
+//   --baseline <file>   with --replay: compare against earlier results and
+//                       exit with 1 when a limit is exceeded
+//   --max-time <pct>    allowed p99 frame/CPU time growth, default 10
+//   --max-mem <pct>     allowed peak memory growth, default 5
+//   --telemetry <prefix>
+//                       record gameplay telemetry to prefix_NNNN.gtl files
+//   --boards <n>        show a wall of n bot-played boards instead of the game
+//   --sweep-frames <f>  with --boards: time f uncapped frames at 1, 2, 4...
+//                       up to n boards and print how the renderer scales
+typedef struct
+{
+    const char *record;
+    const char *replay;
+    const char *benchOut;
+    const char *baseline;
+    float maxTimePct;
+    float maxMemPct;
+    const char *telemetry;
+    int boards;
+    int sweepFrames;
+} Options;
+
+static int ParseOptions(int argc, char **argv, Options *o)
+{
+    memset(o, 0, sizeof(*o));
+    o->maxTimePct = 10.0f;
+    o->maxMemPct = 5.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+            return 0;
+        if (strcmp(argv[i], "--record") == 0)
+            o->record = value;
+        else if (strcmp(argv[i], "--replay") == 0)
+            o->replay = value;
+        else if (strcmp(argv[i], "--bench-out") == 0)
+            o->benchOut = value;
+        else if (strcmp(argv[i], "--baseline") == 0)
+            o->baseline = value;
+        else if (strcmp(argv[i], "--max-time") == 0)
+            o->maxTimePct = (float)atof(value);
+        else if (strcmp(argv[i], "--max-mem") == 0)
+            o->maxMemPct = (float)atof(value);
+        else if (strcmp(argv[i], "--telemetry") == 0)
+            o->telemetry = value;
+        else if (strcmp(argv[i], "--boards") == 0)
+            o->boards = atoi(value);
+        else if (strcmp(argv[i], "--sweep-frames") == 0)
+            o->sweepFrames = atoi(value);
+        else
+            return 0;
+        i++;
+    }
+    if (o->boards < 0 || o->boards > WALL_MAX_BOARDS || (o->sweepFrames > 0 && o->boards == 0))
+        return 0;
+    if (o->boards > 0 && (o->replay != NULL || o->record != NULL))
+        return 0;
+    return (o->benchOut == NULL && o->baseline == NULL) || o->replay != NULL;
+}
+
+// Board wall state, owned by the update like Game is
+typedef struct
+{
+    BoardWall wall;
+    double now;
+    int requested; // Board count the next update switches to
+    float width;
+    float height;
+} Wall;
+
+static void WallUpdate(void *user, RenderList *out)
+{
+    Wall *v = user;
+    if (v->requested != v->wall.count)
+        BoardWallResize(&v->wall, v->requested, v->now);
+    BoardWallUpdate(&v->wall, v->now);
+    RenderBoardWall(out, &v->wall, v->width, v->height);
+}
+
+// Runs the board wall until the window closes or the sweep is done. UP and
+// DOWN add and remove boards; a sweep doubles the count after every timed
+// run instead.
+static void RunWall(const Options *o, const BoardArt *art, Music bgm, int screenWidth, int screenHeight)
+{
+    static Wall wall;
+    int sweeping = o->sweepFrames > 0;
+    wall.width = (float)screenWidth;
+    wall.height = (float)screenHeight;
+    wall.requested = sweeping ? 1 : o->boards;
+    wall.now = GetTime();
+    BoardWallInit(&wall.wall, wall.requested, (unsigned int)time(NULL), wall.now);
+
+    static RenderList serialList;
+    int pipelined = RenderPipelineStart(WallUpdate, &wall);
+    if (!pipelined)
+        TraceLog(LOG_WARNING, "RENDER: Could not start the update thread, updating in line");
+
+    Texture2D sprites[SPRITE_COUNT] = {0};
+    BoardArtSprites(art, sprites);
+
+    if (sweeping)
+    {
+        SetTargetFPS(0);
+        printf("%-8s %12s %12s %12s %10s %10s %14s\n", "boards", "frame p50", "frame p99", "cpu p99", "batches",
+               "commands", "p50 per board");
+    }
+    int frames = 0; // Sweep: frames drawn at the current step
+    int shown = wall.requested;
+    int next = 0; // Sweep: board count for the next timed run
+    while (!WindowShouldClose())
     {
-        int randIdx = rand() % totalCards;
-        if (cards[randIdx].type == chosenType)
-            idx = randIdx;
+        if (sweeping)
+            BenchFrameBegin();
+        double now = GetTime();
+        UpdateMusicStream(bgm);
+
+        const RenderList *list;
+        if (pipelined)
+        {
+            list = RenderPipelineWait();
+        }
+        else
+        {
+            wall.now = now;
+            RenderListClear(&serialList);
+            WallUpdate(&wall, &serialList);
+            RenderListSort(&serialList);
+            list = &serialList;
+        }
+        // The update is idle here, so its board count can be read and changed
+        shown = wall.wall.count;
+        if (next > 0)
+        {
+            wall.requested = next;
+            next = 0;
+        }
+        if (!sweeping && IsKeyPressed(KEY_UP) && wall.requested < WALL_MAX_BOARDS)
+            wall.requested++;
+        if (!sweeping && IsKeyPressed(KEY_DOWN) && wall.requested > 1)
+            wall.requested--;
+        if (pipelined)
+        {
+            wall.now = now;
+            RenderPipelineKick();
+        }
+
+        BeginDrawing();
+        ClearBackground((Color){25, 25, 25, 255});
+        RenderStats rs = {0};
+        if (list != NULL)
+            rs = RenderListSubmit(list, sprites, SPRITE_COUNT);
+        RenderPipelineStats ps = RenderPipelineGetStats();
+        TelemetryRecord(TEL_RENDER, rs.commands, rs.textureSwitches, (unsigned int)(ps.updateMs * 1000.0f), ps.waitMs);
+        DrawText(TextFormat("%d boards  %d commands  %d texture switches  update %.2f ms  %d FPS", shown,
+                            rs.commands, rs.textureSwitches, ps.updateMs, GetFPS()),
+                 10, screenHeight - 20, 10, LIME);
+        EndDrawing();
+#if defined(GOWTHER_LATE_LATCH)
+        // raylib leaves swap, polling and pacing to us in this build
+        SwapScreenBuffer();
+        if (!sweeping && now + 1.0 / 60.0 > GetTime())
+            WaitTime(now + 1.0 / 60.0 - GetTime());
+        PollInputEvents();
+#endif
+
+        if (!sweeping)
+            continue;
+        // Each step warms up on its own, whatever BenchFinish would skip: the
+        // first frames still show the previous board count (the pipeline runs
+        // a frame behind) and the new boards' first uploads
+        if (frames >= BENCH_WARMUP_FRAMES)
+            BenchFrameEnd(rs.textureSwitches);
+        if (++frames == BENCH_WARMUP_FRAMES)
+            BenchStart();
+        if (frames < BENCH_WARMUP_FRAMES + o->sweepFrames)
+            continue;
+        BenchResult r = BenchFinish();
+        printf("%-8d %9.2f ms %9.2f ms %9.2f ms %10.1f %10d %11.3f ms\n", shown, r.frameP50, r.frameP99, r.cpuP99,
+               r.batchesAvg, rs.commands, r.frameP50 / shown);
+        fflush(stdout);
+        if (wall.requested >= o->boards)
+            break;
+        next = wall.requested * 2 < o->boards ? wall.requested * 2 : o->boards;
+        frames = 0;
     }
-    return idx;
+    RenderPipelineStop();
+    TraceLog(LOG_INFO, "WALL: %u matches started, %u picks", wall.wall.matchesStarted, wall.wall.picks);
+}
+
+// Everything main set up, in reverse
+static void Shutdown(void)
+{
+    CaptureStop(); // Needs the GL context, so before CloseWindow
+    TelemetryStop();
+    ResShutdown(); // Unloads every image, texture and the music stream
+    CloseAudioDevice();
+    CloseWindow();
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
-    srand((unsigned)time(NULL));
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        TraceLog(LOG_ERROR, "usage: %s [--record file | --replay file [--bench-out file] [--baseline file] "
+                            "[--max-time pct] [--max-mem pct] | --boards n [--sweep-frames f]] [--telemetry prefix]", argv[0]);
+        return 2;
+    }
+    unsigned int seed = (unsigned int)time(NULL);
+    int replaying = options.replay != NULL;
+    if (replaying && !ReplayOpen(options.replay, &seed))
+    {
+        TraceLog(LOG_ERROR, "REPLAY: Could not read %s", options.replay);
+        return 2;
+    }
+    if (options.record != NULL && !ReplayRecordStart(options.record, seed))
+        TraceLog(LOG_WARNING, "REPLAY: Could not create %s, not recording", options.record);
 
     const int screenWidth = 1366;
     const int screenHeight = 768;
     InitWindow(screenWidth, screenHeight, "GOWTHER");
     InitAudioDevice();   // Initialize audio system
+    ResInit(MEMORY_BUDGET);
+    if (options.telemetry != NULL && !TelemetryStart(options.telemetry))
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not open output file, recording disabled");
+    // Played back sessions are not the player's matches
+    if (!replaying && options.boards == 0 && !StatsOpen("gowther_stats"))
+        TraceLog(LOG_WARNING, "STATS: Could not open the stats store, matches will not be recorded");
+    BoardInitZobrist(); // Once, before any match or board wall is created
+    if (EffectInit() != 0)
+        TraceLog(LOG_WARNING, "EFFECTS: Some card effects did not compile and will do nothing");
 
     // Load background music (must be a file like .mp3, .ogg, .wav)
-    Music bgm = LoadMusicStream("dechire.mp3");
+    Music bgm = ResGetMusic(ResLoadMusic("dechire.mp3", SCOPE_GLOBAL));
 
     // Play music
     PlayMusicStream(bgm);
     SetMusicVolume(bgm, 0.5f);  // optional: set volume to 50%
-    SetTargetFPS(60);
-    Card cards[12];
-
-    // Load Images
-    Image mugSold = LoadImage("mughalSoldier.png");
-    Image boltu = LoadImage("bangabaltu.png");
-    Image claw = LoadImage("clawarchi.png");
-    Image fog = LoadImage("fog.png");
-    Image frost = LoadImage("frostbite.png");
-    Image hitler = LoadImage("hitler.png");
-    Image khalid = LoadImage("khalid bin walid.png");
-    Image mongarch = LoadImage("mongolArcher.png");
-    Image odyss = LoadImage("odysseus.png");
-    Image storm = LoadImage("storm.png");
-    Image suleiman = LoadImage("suleiman.png");
-    Image trebuchet = LoadImage("trebuchet.png");
-
-    // Create Cards
-    cards[0] = CreateCard(CARD_NORMAL, ROW_MELEE, 3, mugSold, 0, 0);
-    cards[1] = CreateCard(CARD_SPECIAL_UNIT, ROW_MELEE, 3, boltu, 0, 1);
-    cards[2] = CreateCard(CARD_HERO, ROW_SIEGE, 15, claw, 1, 0);
-    cards[3] = CreateCard(CARD_WEATHER, ROW_GLOBAL, 0, fog, 0, 2);
-    cards[4] = CreateCard(CARD_WEATHER, ROW_GLOBAL, 0, frost, 0, 1);
-    cards[11] = CreateCard(CARD_LEADER, ROW_GLOBAL, 0, hitler, 0, 0);
-    cards[6] = CreateCard(CARD_HERO, ROW_MELEE, 15, khalid, 1, 0);
-    cards[7] = CreateCard(CARD_NORMAL, ROW_RANGED, 6, mongarch, 0, 0);
-    cards[8] = CreateCard(CARD_HERO, ROW_RANGED, 15, odyss, 1, 0);
-    cards[9] = CreateCard(CARD_WEATHER, ROW_GLOBAL, 0, storm, 0, 3);
-    cards[10] = CreateCard(CARD_LEADER, ROW_GLOBAL, 0, suleiman, 0, 0);
-    cards[5] = CreateCard(CARD_NORMAL, ROW_SIEGE, 8, trebuchet, 0, 0);
-
-    // UI Textures
-    Texture2D menuBG = LoadTexture("main menu.jpg");
-    Texture2D gameBoard = LoadTexture("gameBoard.jpg");
-    Texture2D upboard=LoadTexture("upboard.png");
-    Texture2D downboard=LoadTexture("downboard.png");
-    Texture2D buttons = LoadTexture("buttons.png");
-    Texture2D timer = LoadTexture("time.png");
-    Texture2D score = LoadTexture("score.png");
-    Texture2D frostTex=LoadTexture("frost.jpg");
-
-    Rectangle btnPlay = {200, 320, 200, 89};
-    Rectangle btnQuit = {200, 390, 200, 89};
-
-    enum GameState
-    {
-        MENU,
-        PLAY,
-        HELP,
-        EXIT
-    };
-    int gameState = MENU;
-
-    int queue[MAX_CARDS];
-    for (int i = 0; i < MAX_CARDS; i++)
+    SetTargetFPS(replaying ? 0 : 60); // Played back sessions run uncapped
+
+    // Card artwork and the board around it
+    BoardArt boardArt;
+    BoardArtLoad(&boardArt);
+
+    if (options.boards > 0)
     {
-        queue[i] = GetRandomCardIndex(cards, 10);
+        RunWall(&options, &boardArt, bgm, screenWidth, screenHeight);
+        Shutdown();
+        return 0;
     }
 
-    float offsetY = 0;
+    // UI Textures, loaded while a menu screen is up
+    ResourceHandle menuBG = RES_INVALID;
+    ResourceHandle buttons = RES_INVALID;
+    int menuLoaded = 0;
+    Texture2D sprites[SPRITE_COUNT] = {0};
+
     const float BASE_SPEED = 100.0f; // px/sec
     const int CARD_HEIGHT = 135;
-    const int CARD_WIDTH = 79;
-
-    int rowCounts[3] = {0};                    // melee, ranged, siege counts
-    int rs1[MAX_ROW_CARDS]; memset(rs1, -1, sizeof(rs1));
-    int ra1[MAX_ROW_CARDS]; memset(ra1, -1, sizeof(ra1));
-    int rsg1[MAX_ROW_CARDS]; memset(rsg1, -1, sizeof(rsg1));
-    int frosto=0;
-    int foggo=0;
-    int stormo=0;
-
-    int scores[3]={0};
 
-    while (!WindowShouldClose())
+    Game game = {0};
+    game.state = MENU;
+    game.btnPlay = (Rectangle){200, 320, 200, 89};
+    game.btnStats = (Rectangle){200, 390, 200, 89};
+    game.btnQuit = (Rectangle){200, 460, 200, 89};
+    game.seed = seed;
+    game.statPlayers[0] = StatsPlayer("Player");
+    game.statPlayers[1] = -1; // Single seat: nobody plays against us yet
+    for (int i = 0; i < CARD_DEF_COUNT; i++)
+        TextCopy(game.cardNames[i], GetFileNameWithoutExt(cardDefs[i].image));
+
+    // Single seat for now: no turns and no match clock
+    game.config = MatchDefaultConfig();
+    game.config.speed = BASE_SPEED;
+    game.config.pitch = CARD_HEIGHT + GAP;
+    game.config.cardHeight = CARD_HEIGHT;
+    game.config.zoneY = screenHeight / 2 - CARD_HEIGHT / 2;
+    game.config.turnTime = 0;
+    game.config.totalTime = 0;
+
+    // Picks are timestamped and resolved against the carousel at that instant
+    const int pickKeys[] = {KEY_ENTER};
+    InputQueue input;
+    InputInit(&input, pickKeys, 1);
+    const int frameKeys[] = {KEY_BACKSPACE, KEY_F2, KEY_F3, KEY_F4, KEY_F9, KEY_F11};
+    InputLatchKeys(&input, frameKeys, sizeof(frameKeys) / sizeof(frameKeys[0]));
+    InputLatency latency;
+    InputLatencyInit(&latency);
+
+    // The update for the next frame runs on a worker while this thread draws
+    // the last one. Late latching is about latency, so that build keeps the
+    // update in line, after the freshest possible input.
+    static RenderList serialList;
+#if defined(GOWTHER_LATE_LATCH)
+    int pipelined = 0;
+#else
+    int pipelined = RenderPipelineStart(GameUpdate, &game);
+    if (!pipelined)
+        TraceLog(LOG_WARNING, "RENDER: Could not start the update thread, updating in line");
+#endif
+
+    int showMemory = 0;
+    int showLatency = 0;
+    int showRender = 0;
+
+    if (replaying)
+        BenchStart();
+    int replayDone = 0;
+    while (!WindowShouldClose() && !replayDone)
     {
-        if(IsKeyPressed(KEY_F11))
+        double now = GetTime();
+        if (replaying)
+            BenchFrameBegin();
+        TelemetryRecord(TEL_FRAME, 0, 0, 0, GetFrameTime() * 1000.0f);
+#if !defined(GOWTHER_LATE_LATCH)
+        InputSample(&input, now);
+#endif
+
+        if(InputKeyPressed(&input, KEY_F11))
         {
             ToggleFullscreen();
         }
+        if (InputKeyPressed(&input, KEY_F3))
+            showMemory = !showMemory;
+        if (InputKeyPressed(&input, KEY_F2))
+            showLatency = !showLatency;
+        if (InputKeyPressed(&input, KEY_F4))
+            showRender = !showRender;
+        if (InputKeyPressed(&input, KEY_F9))
+        {
+            if (CaptureIsActive())
+                CaptureStop();
+            else
+                CaptureStart(TextFormat("gowther_capture_%ld", (long)time(NULL)), CAPTURE_RAW);
+        }
         UpdateMusicStream(bgm);
-        Vector2 mouse = GetMousePosition();
 
-        // Input
-        if (gameState == MENU)
+        // Update: collect the finished frame, then hand over input for the next
+        const RenderList *list;
+        if (pipelined)
         {
-            if (CheckCollisionPointRec(mouse, btnPlay) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-                gameState = PLAY;
-            if (CheckCollisionPointRec(mouse, btnQuit) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-                gameState = EXIT;
+            list = RenderPipelineWait();
         }
-        if (gameState == EXIT)
-            break;
-
-        // Update
-        if (gameState == PLAY)
+        else
         {
-            float dt = GetFrameTime();
-
-            // Scroll cards upwards
-            offsetY -= BASE_SPEED * dt;
-            if (offsetY < -(CARD_HEIGHT + GAP))
-            {
-                offsetY += (CARD_HEIGHT + GAP);
+            if (!GameSetInput(&game, &input, now, replaying))
+                break;
+            RenderListClear(&serialList);
+            GameUpdate(&game, &serialList);
+            RenderListSort(&serialList);
+            list = &serialList;
+        }
+        for (int i = 0; i < game.acceptedCount && !replaying; i++)
+            InputLatencyPress(&latency, game.accepted[i]);
+        game.acceptedCount = 0;
 
-                // Shift queue up
-                for (int i = 0; i < MAX_CARDS - 1; i++)
-                    queue[i] = queue[i + 1];
+        // Menu art is not needed during a match
+        if ((game.state == PLAY || game.state == EXIT) && menuLoaded)
+        {
+            ResReleaseScope(SCOPE_SCREEN);
+            menuLoaded = 0;
+        }
+        else if ((game.state == MENU || game.state == STATS) && !menuLoaded)
+        {
+            menuBG = ResLoadTexture("main menu.jpg", SCOPE_SCREEN);
+            buttons = ResLoadTexture("buttons.png", SCOPE_SCREEN);
+            menuLoaded = 1;
+        }
+        if (game.state == EXIT)
+            break;
 
-                // Add new random card at the bottom
-                queue[MAX_CARDS - 1] = GetRandomCardIndex(cards, 12);
-            }
+        if (pipelined)
+        {
+            // The last recorded frame still gets drawn; no new update is started
+            replayDone = !GameSetInput(&game, &input, now, replaying);
+            if (!replayDone)
+                RenderPipelineKick();
         }
+        InputClearLatched(&input);
 
         // Draw
+        BoardArtSprites(&boardArt, sprites);
+        sprites[SPRITE_MENU_BG] = menuLoaded ? ResGetTexture(menuBG) : (Texture2D){0};
+        sprites[SPRITE_BUTTONS] = menuLoaded ? ResGetTexture(buttons) : (Texture2D){0};
+
         BeginDrawing();
         ClearBackground((Color){25, 25, 25, 255});
 
-        if (gameState == MENU)
+        RenderStats rs = {0};
+        if (list != NULL)
+            rs = RenderListSubmit(list, sprites, SPRITE_COUNT);
+        RenderPipelineStats ps = RenderPipelineGetStats();
+        TelemetryRecord(TEL_RENDER, rs.commands, rs.textureSwitches, (unsigned int)(ps.updateMs * 1000.0f), ps.waitMs);
+
+        if (showMemory)
+            ResDrawReport(10, 10);
+        if (showLatency)
         {
-            DrawTexture(menuBG, 0, 0, WHITE);
-            DrawTexture(buttons, btnPlay.x, btnPlay.y, WHITE);
-            DrawText("PLAY", btnPlay.x + 65, btnPlay.y + 42, 30,
-                     CheckCollisionPointRec(mouse, btnPlay) ? YELLOW : WHITE);
-            DrawTexture(buttons, btnQuit.x, btnQuit.y, WHITE);
-            DrawText("Quit", btnQuit.x + 65, btnQuit.y + 42, 30,
-                     CheckCollisionPointRec(mouse, btnQuit) ? YELLOW : WHITE);
+            InputLatencyReport lr = InputLatencyGetReport(&latency);
+            DrawText(TextFormat("Input latency: avg %.1f ms  p99 %.1f ms  max %.1f ms  (%d picks)",
+                                lr.avg * 1000.0f, lr.p99 * 1000.0f, lr.max * 1000.0f, lr.count),
+                     10, screenHeight - 20, 10, LIME);
         }
-        else if (gameState == PLAY)
+        if (showRender)
         {
-            DrawTexture(gameBoard, 0, 0, WHITE);
+            DrawText(TextFormat("Render: %d commands  %d texture switches  update %.2f ms  waited %.2f ms%s",
+                                rs.commands, rs.textureSwitches, ps.updateMs, ps.waitMs,
+                                pipelined ? "" : "  (in line)"),
+                     10, screenHeight - 34, 10, LIME);
+        }
 
-            int selectedIndex = -1;
+        // Everything above goes into the recording; the indicator does not
+        CaptureFrame();
+        if (CaptureIsActive())
+        {
+            CaptureStats cs = CaptureGetStats();
+            DrawCircle(screenWidth - 20, 20, 8, RED);
+            DrawText(TextFormat("REC %02d:%02d  dropped %u", (int)cs.seconds / 60, (int)cs.seconds % 60, cs.dropped),
+                     screenWidth - 200, 12, 10, RED);
+        }
 
-            // Selection zone in the middle
-            Rectangle selectZone = {screenWidth / 2 - CARD_WIDTH / 2,
-                                    screenHeight / 2 - CARD_HEIGHT / 2,
-                                    CARD_WIDTH, CARD_HEIGHT};
-            // Draw scrolling cards
-            for (int i = 0; i < MAX_CARDS; i++)
-            {
-                float x = screenWidth / 2 - CARD_WIDTH / 2;
-                float y = offsetY + i * (CARD_HEIGHT + GAP);
-                Rectangle cardRect = {x, y, CARD_WIDTH, CARD_HEIGHT};
-
-                DrawTexture(upboard,609,0,WHITE);
-                DrawTexture(downboard,607,702,WHITE);
-                DrawTexture(timer,618,0,BROWN);
-                DrawTexture(timer,618,640,BROWN);
-                DrawTexture(cards[queue[i]].normTex, x, y, WHITE);
-
-                // Check if this card overlaps selection zone
-                if (CheckCollisionRecs(selectZone, cardRect))
-                {
-                    selectedIndex = queue[i];
-                }
-            }
+        EndDrawing();
+#if defined(GOWTHER_LATE_LATCH)
+        // raylib leaves swap, polling and pacing to us in this build
+        SwapScreenBuffer();
+        InputLatencyPresented(&latency, GetTime());
+        InputWaitAndPoll(&input, replaying ? now : now + 1.0 / 60.0);
+#else
+        // Upper bound: EndDrawing also includes the frame pacing wait
+        InputLatencyPresented(&latency, GetTime());
+#endif
+        if (replaying)
+            BenchFrameEnd(rs.textureSwitches);
+    }
 
-            // If Enter pressed, confirm card
-            if (selectedIndex != -1 && IsKeyPressed(KEY_ENTER))
-            {
-                Card picked = cards[selectedIndex];
-
-                if(picked.row == ROW_MELEE)
-                {
-                    if(rowCounts[2] <MAX_ROW_CARDS)
-                    {
-                        rs1[rowCounts[2]]=selectedIndex;
-                        scores[2]+=cards[selectedIndex].currentPower;
-                        rowCounts[2]++;
-                    }
-                }
-                else if(picked.row == ROW_RANGED)
-                {
-                    if(rowCounts[1] <MAX_ROW_CARDS)
-                    {
-                        ra1[rowCounts[1]]=selectedIndex;
-                        scores[1]+=cards[selectedIndex].currentPower;
-                        rowCounts[1]++;
-                    }
-                }
-                else if(picked.row == ROW_SIEGE)
-                {
-                    if(rowCounts[0] <MAX_ROW_CARDS)
-                    {
-                        rsg1[rowCounts[0]]=selectedIndex;
-                        scores[0]+=cards[selectedIndex].currentPower;
-                        rowCounts[0]++;
-                    }
-                }
-                else if(picked.row == ROW_GLOBAL)
-                {
-                    if(picked.type == CARD_WEATHER)
-                    {
-                        if(picked.isGold == 1)
-                        {
-                            frosto=1;
-                        }
-                    }
-                }
-            }
+    RenderPipelineStop(); // Waits for an update in flight
+    if (game.state == PLAY) // Window closed mid-match
+        RecordMatch(&game.match, game.statPlayers, GetTime());
+    StatsClose();
 
-            for(int i=0;i<rowCounts[2];i++)
-            {
-                int cardIdx=rs1[i];
-                int x=463;
-                int y=65+4+i*79;
-                DrawTexture(cards[cardIdx].rotatedTex, x, y, WHITE);
-            }
-            for(int i=0;i<rowCounts[1];i++)
-            {
-                int cardIdx=ra1[i];
-                int x=311;
-                int y=65+4+i*79;
-                DrawTexture(cards[cardIdx].rotatedTex, x, y, WHITE);
-            }
-            for(int i=0;i<rowCounts[0];i++)
+    int status = 0;
+    if (replaying)
+    {
+        ReplayClose();
+        BenchResult result = BenchFinish();
+        TraceLog(LOG_INFO, "BENCH: %d frames, p50 %.2f ms, p99 %.2f ms, CPU p99 %.2f ms, %.1f batches, peak %ld KB",
+                 result.frames, result.frameP50, result.frameP99, result.cpuP99, result.batchesAvg, result.peakRssKb);
+        if (options.benchOut != NULL && !BenchWrite(options.benchOut, &result))
+            TraceLog(LOG_WARNING, "BENCH: Could not write %s", options.benchOut);
+        if (options.baseline != NULL)
+        {
+            BenchResult baseline;
+            if (!BenchRead(options.baseline, &baseline))
             {
-                int cardIdx=rsg1[i];
-                int x=159;
-                int y=65+4+i*79;
-                DrawTexture(cards[cardIdx].rotatedTex, x, y, WHITE);
+                TraceLog(LOG_ERROR, "BENCH: Could not read baseline %s", options.baseline);
+                status = 2;
             }
-            if(frosto == 1)
+            else if (BenchCompare(&baseline, &result, options.maxTimePct, options.maxMemPct) > 0)
             {
-                DrawTexture(frostTex, 464, 76, Fade(WHITE,0.7f));
-                DrawTexture(frostTex, 766, 76, Fade(WHITE,0.7f));
+                status = 1;
             }
-            DrawTexture(score,494,681,BROWN);
-            DrawTexture(score,342,681,BROWN);
-            DrawTexture(score,190,681,BROWN);
-            DrawTexture(score,805,681,BROWN);
-            DrawTexture(score,957,681,BROWN);
-            DrawTexture(score,1102,681,BROWN);
-            DrawText(TextFormat("%d", scores[2]), 517, 700, 30, WHITE);
-            DrawText(TextFormat("%d", scores[1]), 365, 700, 30, WHITE);
-            DrawText(TextFormat("%d", scores[0]), 213, 700, 30, WHITE);
         }
-
-        EndDrawing();
     }
+    ReplayRecordStop();
 
-    UnloadMusicStream(bgm);
-    CloseAudioDevice();
-    CloseWindow();
-    return 0;
-}
\ No newline at end of file
+    InputLatencyReport lr = InputLatencyGetReport(&latency);
+    if (lr.count > 0)
+        TraceLog(LOG_INFO, "INPUT: Press-to-present latency avg %.2f ms, p99 %.2f ms, max %.2f ms over %d picks",
+                 lr.avg * 1000.0f, lr.p99 * 1000.0f, lr.max * 1000.0f, lr.count);
+
+    Shutdown();
+    return status;
+}
@@ -0,0 +1,158 @@
+#include "match.h"
+#include "effects.h"
+#include "telemetry.h"
+#include <string.h>
+
+// Board geometry the carousel is laid out with on a 1366x768 screen
+MatchConfig MatchDefaultConfig(void)
+{
+    MatchConfig c;
+    c.speed = 100.0f;
+    c.pitch = 135 + 10;
+    c.cardHeight = 135;
+    c.zoneY = 768 / 2 - 135 / 2;
+    c.turnTime = TURN_TIME;
+    c.totalTime = TOTAL_GAME_TIME;
+    return c;
+}
+
+void MatchInit(MatchState *m, const MatchConfig *config, unsigned int seed, double now)
+{
+    memset(m, 0, sizeof(*m));
+    m->config = *config;
+    BoardClear(&m->board, &m->hash);
+    CardPoolInit(&m->pool);
+    CarouselInit(&m->carousel, &m->pool, config->speed, config->pitch, seed, now);
+    m->startTime = now;
+    m->turnStart = now;
+}
+
+// Put a card on the player's side. Returns 1 if the card was used up
+// (placed in a row or spent as weather), 0 if it stays where it was.
+int MatchPlayCard(MatchState *m, int player, CardHandle card)
+{
+    const CardDef *def = CardDefOf(&m->pool, card);
+    int defId = CardDefId(&m->pool, card);
+    const EffectProgram *effect = EffectProgramOf(defId);
+
+    if (def->row == ROW_GLOBAL)
+    {
+        // Weather and leaders act only through their effect
+        if (effect == NULL)
+            return 0;
+        EffectRun(effect, m, player, ROW_GLOBAL);
+        if (def->type == CARD_WEATHER)
+            TelemetryRecord(TEL_WEATHER, defId, m->board.flags & BOARD_WEATHER_MASK, 0, (float)player);
+        // Spent as soon as it is played
+        CardFree(&m->pool, card);
+        return 1;
+    }
+
+    int row = def->row;
+    int slot = BoardPlace(&m->board, &m->hash, player, row, CardPower(&m->pool, card), def->isHero);
+    if (slot == -1)
+        return 0;
+
+    m->rows[player][row][slot] = card;
+    EffectWeatherPlaced(m, player, row, slot);
+    TelemetryRecord(TEL_ROW_PLACE, defId, row, CardPower(&m->pool, card), (float)player);
+    if (effect != NULL)
+        EffectRun(effect, m, player, row);
+    return 1;
+}
+
+static void NextTurn(MatchState *m, double now, int timedOut)
+{
+    m->turn = (m->turn + 1) % MATCH_PLAYERS;
+    BoardSetFlags(&m->board, &m->hash, m->turn ? m->board.flags | BOARD_TURN : m->board.flags & ~BOARD_TURN);
+    m->turnStart = now;
+    TelemetryRecord(TEL_TURN_SWITCH, m->turn, timedOut, 0, 0.0f);
+}
+
+// Take whatever card was in the selection zone at time t. Returns the
+// carousel slot that was taken, or -1.
+int MatchPick(MatchState *m, int player, double t)
+{
+    if (m->over)
+        return -1;
+    if (m->config.turnTime > 0 && player != m->turn)
+        return -1;
+
+    CarouselAdvanceTo(&m->carousel, &m->pool, t);
+    int slot = CarouselSlotInZone(&m->carousel, m->config.zoneY, m->config.cardHeight);
+    if (slot == -1)
+        return -1;
+
+    // How long the card had been in the zone when it was taken
+    CardHandle card = m->carousel.slots[slot];
+    float offset = CarouselOffset(&m->carousel);
+    float y = offset + slot * m->config.pitch;
+    float reaction = (m->config.zoneY + m->config.cardHeight - y) / m->config.speed;
+    int defId = CardDefId(&m->pool, card);
+
+    if (!MatchPlayCard(m, player, card))
+        return -1;
+    TelemetryRecord(TEL_CARD_PICK, defId, m->carousel.headSeq, (unsigned int)(reaction * 1e6f), offset);
+
+    // The instance now belongs to a row (or is gone), not the carousel
+    m->carousel.slots[slot] = CARD_NONE;
+
+    if (m->config.turnTime > 0)
+        NextTurn(m, t, 0);
+    return slot;
+}
+
+// Apply timeouts up to `now`. Returns MATCH_EVENT_* bits.
+int MatchTick(MatchState *m, double now)
+{
+    if (m->over)
+        return 0;
+
+    int events = 0;
+    if (m->config.totalTime > 0 && now - m->startTime >= m->config.totalTime)
+    {
+        m->over = 1;
+        TelemetryRecord(TEL_MATCH_END, MatchTotal(m, 0), MatchTotal(m, 1), MatchWinner(m) + 1, 0.0f);
+        return MATCH_EVENT_OVER;
+    }
+    // Auto-switch turn when the seat runs out of time
+    if (m->config.turnTime > 0 && now - m->turnStart >= m->config.turnTime)
+    {
+        NextTurn(m, m->turnStart + m->config.turnTime, 1);
+        events |= MATCH_EVENT_TURN;
+    }
+    CarouselAdvanceTo(&m->carousel, &m->pool, now);
+    return events;
+}
+
+// Earliest time MatchTick has something to do, or 0 if nothing is pending
+double MatchNextDeadline(const MatchState *m)
+{
+    if (m->over)
+        return 0.0;
+
+    double next = 0.0;
+    if (m->config.turnTime > 0)
+        next = m->turnStart + m->config.turnTime;
+    if (m->config.totalTime > 0)
+    {
+        double end = m->startTime + m->config.totalTime;
+        if (next == 0.0 || end < next)
+            next = end;
+    }
+    return next;
+}
+
+int MatchTotal(const MatchState *m, int player)
+{
+    return BoardTotal(&m->board, player);
+}
+
+// Winning seat, or -1 for a draw
+int MatchWinner(const MatchState *m)
+{
+    int lead = BoardEvaluate(&m->board, 0);
+    if (lead == 0)
+        return -1;
+    return lead > 0 ? 0 : 1;
+}
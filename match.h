@@ -0,0 +1,61 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "board.h"
+#include "cards.h"
+#include "carousel.h"
+
+// Rules of one match, with no raylib dependency so the same code runs in the
+// game and in the headless server. Times are in seconds on whatever clock the
+// caller uses (GetTime() in the game, CLOCK_MONOTONIC in the server).
+
+#define MATCH_PLAYERS 2
+#define MATCH_ROWS 3    // ROW_MELEE, ROW_RANGED, ROW_SIEGE
+#define MAX_ROW_CARDS 8 // per row
+
+#define TURN_TIME 6.0f
+#define TOTAL_GAME_TIME 120.0f
+
+// Weather in play, one bit per weather card
+#define WEATHER_FROST 0x01
+#define WEATHER_FOG 0x02
+#define WEATHER_STORM 0x04
+
+// What MatchTick found had happened
+#define MATCH_EVENT_TURN 0x01
+#define MATCH_EVENT_OVER 0x02
+
+typedef struct
+{
+    float speed;      // Carousel px/sec
+    float pitch;      // Card height + gap
+    float cardHeight; // Height of a card and of the selection zone
+    float zoneY;      // Top of the selection zone, carousel coordinates
+    float turnTime;   // 0 = no turns, any seat may pick at any time
+    float totalTime;  // 0 = untimed
+} MatchConfig;
+
+typedef struct
+{
+    MatchConfig config;
+    CardPool pool;
+    Carousel carousel;
+    PackedBoard board; // Powers, occupancy, weather and turn; scores come from here
+    unsigned long long hash; // Zobrist hash of board, kept up to date
+    CardHandle rows[MATCH_PLAYERS][MATCH_ROWS][MAX_ROW_CARDS]; // Instances behind the board slots
+    int turn; // Seat allowed to pick
+    double startTime;
+    double turnStart;
+    int over;
+} MatchState;
+
+MatchConfig MatchDefaultConfig(void);
+void MatchInit(MatchState *m, const MatchConfig *config, unsigned int seed, double now);
+int MatchPlayCard(MatchState *m, int player, CardHandle card);
+int MatchPick(MatchState *m, int player, double t);
+int MatchTick(MatchState *m, double now);
+double MatchNextDeadline(const MatchState *m);
+int MatchTotal(const MatchState *m, int player);
+int MatchWinner(const MatchState *m);
+
+#endif
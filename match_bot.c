@@ -0,0 +1,317 @@
+/*******************************************************************************************
+*
+*   GOWTHER load-test bot (Linux)
+*
+*   Opens many player connections to a match server over loopback, plays every
+*   turn after a random think time and re-queues when a match ends. Reports
+*   matches played and pick round-trip times.
+*
+*   Optional spectators watch whatever match is live on their server worker,
+*   decode the keyframes and deltas, and report the bytes each one receives.
+*
+*   Usage: match_bot [clients] [host] [port] [seconds] [spectators]
+*
+********************************************************************************************/
+
+#define _GNU_SOURCE
+#include "matchview.h"
+#include "netproto.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 512
+#define BOT_BUF 512
+#define RTT_BUCKETS 200
+#define RTT_BUCKET 0.0001 // 100 us per round-trip bucket
+#define THINK_MIN 0.2
+#define THINK_MAX 2.5
+#define REPORT_INTERVAL 5.0
+#define SPECTATE_RETRY 0.5
+
+typedef struct
+{
+    int fd;
+    int seat;     // -1 until a match starts
+    int turn;     // Seat to pick, as last told by the server
+    double pickAt; // When to send the next pick, 0 if none planned
+    double sentAt; // When the outstanding pick went out, 0 if none
+    unsigned int seq;
+    int spectator;
+    double watchAt; // When a spectator asks for a match again, 0 if watching
+    MatchView view;
+    int inLen;
+    unsigned char in[BOT_BUF];
+} Bot;
+
+static Bot *bots;
+static long long rtt[RTT_BUCKETS + 1];
+static long long picked, rejected, finished, started;
+static long long spectatorBytes, keyframes, deltas, decodeErrors;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double Think(void)
+{
+    return THINK_MIN + (THINK_MAX - THINK_MIN) * (rand() / (double)RAND_MAX);
+}
+
+static void SendMsg(Bot *b, int type, const unsigned char *payload, int len)
+{
+    unsigned char buf[NET_HEADER + NET_MAX_PAYLOAD];
+    buf[0] = (unsigned char)type;
+    buf[1] = (unsigned char)len;
+    memcpy(buf + NET_HEADER, payload, len);
+    if (send(b->fd, buf, NET_HEADER + len, MSG_NOSIGNAL) < 0 && errno != EAGAIN)
+        perror("send");
+}
+
+static void PlanPick(Bot *b, double now)
+{
+    b->pickAt = (b->seat >= 0 && b->turn == b->seat && b->sentAt == 0.0) ? now + Think() : 0.0;
+}
+
+static void RecordRtt(Bot *b, double now)
+{
+    if (b->sentAt == 0.0)
+        return;
+    int bucket = (int)((now - b->sentAt) / RTT_BUCKET);
+    rtt[bucket < RTT_BUCKETS ? bucket : RTT_BUCKETS]++;
+    b->sentAt = 0.0;
+}
+
+static void OnSpectatorMessage(Bot *b, const unsigned char *msg, double now)
+{
+    spectatorBytes += NET_HEADER + msg[1];
+    switch (msg[0])
+    {
+    case MSG_KEYFRAME:
+        keyframes++;
+        if (!MatchViewDecodeKeyframe(&b->view, msg + NET_HEADER, msg[1]))
+            decodeErrors++;
+        break;
+    case MSG_DELTA:
+        deltas++;
+        if (!MatchViewDecodeDelta(&b->view, msg + NET_HEADER, msg[1]))
+            decodeErrors++;
+        break;
+    case MSG_REJECT: // No live match yet
+    case MSG_OVER:
+        b->watchAt = now + SPECTATE_RETRY;
+        break;
+    default:
+        break;
+    }
+}
+
+static void OnMessage(Bot *b, const unsigned char *msg, double now)
+{
+    const unsigned char *p = msg + NET_HEADER;
+    switch (msg[0])
+    {
+    case MSG_WELCOME:
+        b->seat = p[4];
+        b->turn = 0;
+        started++;
+        PlanPick(b, now);
+        break;
+    case MSG_TURN:
+        b->turn = p[0];
+        PlanPick(b, now);
+        break;
+    case MSG_PICKED:
+        if (p[0] == b->seat && NetGetU32(p + 3) == b->seq)
+        {
+            RecordRtt(b, now);
+            picked++;
+        }
+        break;
+    case MSG_REJECT:
+        RecordRtt(b, now);
+        rejected++;
+        // Nothing in the zone: look again shortly if it is still our turn
+        PlanPick(b, now);
+        break;
+    case MSG_OVER:
+        if (b->seat == 0)
+            finished++;
+        b->seat = -1;
+        b->pickAt = 0.0;
+        b->sentAt = 0.0;
+        SendMsg(b, MSG_JOIN, NULL, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+static void Report(double elapsed, int connected, int spectators)
+{
+    long long total = 0, seen = 0;
+    for (int i = 0; i <= RTT_BUCKETS; i++)
+        total += rtt[i];
+    double p50 = 0, p99 = 0, max = 0;
+    for (int i = 0; i <= RTT_BUCKETS; i++)
+    {
+        if (rtt[i] == 0)
+            continue;
+        seen += rtt[i];
+        double us = (i + 1) * RTT_BUCKET * 1e6;
+        if (p50 == 0 && seen * 2 >= total)
+            p50 = us;
+        if (p99 == 0 && seen * 100 >= total * 99)
+            p99 = us;
+        max = us;
+    }
+    printf("%.0fs  connected %d  matches started %lld finished %lld  picks %lld (rejected %lld)  rtt p50<%.0fus p99<%.0fus max<%.0fus\n",
+           elapsed, connected, started / 2, finished, picked, rejected, p50, p99, max);
+    if (spectators > 0)
+        printf("      spectators %d  %.0f B/s each  keyframes %lld deltas %lld  decode errors %lld\n", spectators,
+               spectatorBytes / elapsed / spectators, keyframes, deltas, decodeErrors);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int clients = argc > 1 ? atoi(argv[1]) : 1000;
+    const char *host = argc > 2 ? argv[2] : "127.0.0.1";
+    int port = argc > 3 ? atoi(argv[3]) : NET_DEFAULT_PORT;
+    double duration = argc > 4 ? atof(argv[4]) : 60.0;
+    int spectators = argc > 5 ? atoi(argv[5]) : 0;
+    int total = clients + spectators;
+
+    signal(SIGPIPE, SIG_IGN);
+    srand((unsigned)time(NULL));
+    BoardInitZobrist(); // Same keys as the server, before any board is decoded
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+
+    int epfd = epoll_create1(0);
+    // Players first, so they pair up on the server before spectators arrive
+    bots = calloc(total, sizeof(Bot));
+    int connected = 0;
+    for (int i = 0; i < total; i++)
+    {
+        Bot *b = &bots[i];
+        b->seat = -1;
+        b->spectator = i >= clients;
+        b->fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (b->fd < 0 || connect(b->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            perror("connect");
+            if (b->fd >= 0)
+                close(b->fd);
+            b->fd = -1;
+            continue;
+        }
+        int one = 1;
+        setsockopt(b->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(b->fd, F_SETFL, fcntl(b->fd, F_GETFL, 0) | O_NONBLOCK);
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (unsigned)i};
+        epoll_ctl(epfd, EPOLL_CTL_ADD, b->fd, &ev);
+        if (b->spectator)
+            b->watchAt = 1.0; // Straight away
+        else
+            SendMsg(b, MSG_JOIN, NULL, 0);
+        connected++;
+    }
+
+    double start = Now();
+    double nextReport = start + REPORT_INTERVAL;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (Now() - start < duration)
+    {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, 2);
+        double now = Now();
+
+        for (int e = 0; e < n; e++)
+        {
+            Bot *b = &bots[events[e].data.u32];
+            ssize_t got = recv(b->fd, b->in + b->inLen, BOT_BUF - b->inLen, 0);
+            if (got <= 0)
+            {
+                if (got < 0 && errno == EAGAIN)
+                    continue;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, b->fd, NULL);
+                close(b->fd);
+                b->fd = -1;
+                connected--;
+                continue;
+            }
+            b->inLen += (int)got;
+
+            int off = 0, len;
+            while ((len = NetFrameLength(b->in + off, b->inLen - off)) > 0)
+            {
+                if (b->spectator)
+                    OnSpectatorMessage(b, b->in + off, now);
+                else
+                    OnMessage(b, b->in + off, now);
+                off += len;
+            }
+            memmove(b->in, b->in + off, b->inLen - off);
+            b->inLen -= off;
+        }
+
+        // Spectators between matches ask for any live one
+        for (int i = clients; i < total; i++)
+        {
+            Bot *b = &bots[i];
+            if (b->fd < 0 || b->watchAt == 0.0 || now < b->watchAt)
+                continue;
+            unsigned char p[4];
+            NetPutU32(p, 0);
+            b->watchAt = 0.0;
+            SendMsg(b, MSG_SPECTATE, p, 4);
+        }
+
+        // Send the picks whose think time is up
+        for (int i = 0; i < clients; i++)
+        {
+            Bot *b = &bots[i];
+            if (b->fd < 0 || b->pickAt == 0.0 || now < b->pickAt)
+                continue;
+            unsigned char p[4];
+            NetPutU32(p, ++b->seq);
+            b->pickAt = 0.0;
+            b->sentAt = now;
+            SendMsg(b, MSG_PICK, p, 4);
+        }
+
+        if (now >= nextReport)
+        {
+            Report(now - start, connected, spectators);
+            nextReport += REPORT_INTERVAL;
+        }
+    }
+
+    Report(Now() - start, connected, spectators);
+    return 0;
+}
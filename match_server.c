@@ -0,0 +1,990 @@
+/*******************************************************************************************
+*
+*   GOWTHER headless match server (Linux)
+*
+*   Hosts many matches in one process without raylib. A fixed pool of worker
+*   threads each owns a shard of connections and matches: its own epoll set,
+*   its own hashed timer wheel for turn and game deadlines, and no locks on the
+*   hot path. The main thread only accepts and deals connections in pairs.
+*
+*   Any connection may instead watch a match (MSG_SPECTATE): it gets a
+*   keyframe of the match view, then a bit-packed delta whenever something
+*   other than the carousel's steady motion has changed, checked every 100 ms.
+*   A spectator of a match on another worker is moved to that worker.
+*
+*   Usage: match_server [port] [workers] [turnTime] [totalTime] [maxConns]
+*
+********************************************************************************************/
+
+#define _GNU_SOURCE
+#include "effects.h"
+#include "matchview.h"
+#include "netproto.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 256
+#define CONN_BUF 512
+#define INBOX_SIZE 4096
+#define WHEEL_SLOTS 1024
+#define WHEEL_TICK 0.001 // seconds per wheel slot
+#define JITTER_BUCKETS 400
+#define JITTER_BUCKET 0.00005 // 50 us per lateness bucket
+#define REPORT_INTERVAL 5
+#define SPECTATE_INTERVAL 0.1 // seconds between spectator delta checks
+
+// Epoll tags for the two non-connection fds of a worker
+#define TAG_WAKE 0xFFFFFFFEu
+#define TAG_TICK 0xFFFFFFFFu
+
+typedef struct TimerNode
+{
+    struct TimerNode *next;
+    struct TimerNode *prev;
+    long long tick;  // Absolute wheel tick it fires on
+    double deadline; // Exact time asked for, to measure lateness
+    int armed;
+} TimerNode;
+
+// Hashed timing wheel: one slot per millisecond, deadlines further out than
+// the wheel wait in their slot until their absolute tick comes round.
+typedef struct
+{
+    TimerNode slots[WHEEL_SLOTS]; // Sentinels of circular lists
+    long long current;            // Last tick processed
+    double origin;                // Clock time of tick 0
+} TimerWheel;
+
+typedef struct
+{
+    int fd;
+    int match; // Index into the worker's matches, -1 if none
+    int seat;
+    int inLen;
+    int outLen;
+    int writing;     // EPOLLOUT armed
+    int watching;    // Match index being spectated, -1 if none
+    int nextWatcher; // Next spectator of the same match, -1 at the end
+    unsigned char in[CONN_BUF];
+    unsigned char out[CONN_BUF];
+} Conn;
+
+typedef struct
+{
+    MatchState state;
+    TimerNode timer;
+    int conns[MATCH_PLAYERS];
+    unsigned int id;
+    int active;
+    MatchView view;   // What spectators have been sent so far
+    int watchers;     // First spectator connection, -1 if none
+    int watcherCount;
+} ServerMatch;
+
+// A connection on its way to a worker, optionally to spectate a match there
+typedef struct
+{
+    int fd;
+    unsigned int watch; // Match id, 0 for an ordinary connection
+} PendingConn;
+
+typedef struct
+{
+    int index;
+    pthread_t thread;
+    int epfd;
+    int wakeFd;
+    int tickFd;
+
+    pthread_mutex_t inboxLock;
+    PendingConn inbox[INBOX_SIZE];
+    int inboxCount;
+
+    Conn *conns;
+    int *freeConns;
+    int connCap;
+    int freeConnCount;
+
+    ServerMatch *matches;
+    int *freeMatches;
+    int matchCap;
+    int freeMatchCount;
+    unsigned int nextMatchSeq;
+
+    int waiting; // Connection waiting for an opponent, -1 if none
+    TimerWheel wheel;
+    double nextSpectate;
+
+    // Written only by this worker, read by the reporter thread
+    long long jitter[JITTER_BUCKETS + 1];
+    long long picks;
+    long long started;
+    long long finished;
+    long long liveConns;
+    long long liveMatches;
+    long long spectators;
+    long long spectatorBytes;
+} Worker;
+
+static MatchConfig config;
+static Worker *workers;
+static int workerCount;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void SetNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static void StatAdd(long long *counter, long long v)
+{
+    __atomic_add_fetch(counter, v, __ATOMIC_RELAXED);
+}
+
+//----------------------------------------------------------------------------------
+// Timer wheel
+//----------------------------------------------------------------------------------
+static void WheelInit(TimerWheel *w, double now)
+{
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+        w->slots[i].next = w->slots[i].prev = &w->slots[i];
+    w->current = 0;
+    w->origin = now;
+}
+
+static void WheelCancel(TimerNode *n)
+{
+    if (!n->armed)
+        return;
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->armed = 0;
+}
+
+static void WheelSchedule(TimerWheel *w, TimerNode *n, double deadline)
+{
+    WheelCancel(n);
+    long long tick = (long long)((deadline - w->origin) / WHEEL_TICK) + 1;
+    if (tick <= w->current)
+        tick = w->current + 1;
+
+    TimerNode *head = &w->slots[tick % WHEEL_SLOTS];
+    n->tick = tick;
+    n->deadline = deadline;
+    n->next = head->next;
+    n->prev = head;
+    head->next->prev = n;
+    head->next = n;
+    n->armed = 1;
+}
+
+static ServerMatch *MatchFromTimer(TimerNode *n)
+{
+    return (ServerMatch *)((char *)n - offsetof(ServerMatch, timer));
+}
+
+//----------------------------------------------------------------------------------
+// Connections
+//----------------------------------------------------------------------------------
+static void CloseConn(Worker *wk, int ci);
+
+static void Send(Worker *wk, int ci, int type, const unsigned char *payload, int len)
+{
+    Conn *c = &wk->conns[ci];
+    if (c->fd < 0)
+        return;
+    if (c->outLen + NET_HEADER + len > CONN_BUF)
+    {
+        // Client is not reading; it cannot keep up with its own match
+        CloseConn(wk, ci);
+        return;
+    }
+
+    unsigned char *p = c->out + c->outLen;
+    p[0] = (unsigned char)type;
+    p[1] = (unsigned char)len;
+    memcpy(p + NET_HEADER, payload, len);
+    c->outLen += NET_HEADER + len;
+
+    if (c->writing)
+        return;
+
+    ssize_t n = send(c->fd, c->out, c->outLen, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+        memmove(c->out, c->out + n, c->outLen - n);
+        c->outLen -= (int)n;
+    }
+    else if (n < 0 && errno != EAGAIN)
+    {
+        CloseConn(wk, ci);
+        return;
+    }
+
+    if (c->outLen > 0)
+    {
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.u32 = (unsigned)ci};
+        epoll_ctl(wk->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->writing = 1;
+    }
+}
+
+static void Flush(Worker *wk, int ci)
+{
+    Conn *c = &wk->conns[ci];
+    ssize_t n = send(c->fd, c->out, c->outLen, MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN)
+    {
+        CloseConn(wk, ci);
+        return;
+    }
+    if (n > 0)
+    {
+        memmove(c->out, c->out + n, c->outLen - n);
+        c->outLen -= (int)n;
+    }
+    if (c->outLen == 0)
+    {
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (unsigned)ci};
+        epoll_ctl(wk->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->writing = 0;
+    }
+}
+
+static void Broadcast(Worker *wk, ServerMatch *sm, int type, const unsigned char *payload, int len)
+{
+    // A failed send closes its connection, which can end the match
+    for (int s = 0; s < MATCH_PLAYERS && sm->active; s++)
+    {
+        if (sm->conns[s] >= 0)
+            Send(wk, sm->conns[s], type, payload, len);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Spectators
+//----------------------------------------------------------------------------------
+static void SendToWatchers(Worker *wk, ServerMatch *sm, int type, const unsigned char *payload, int len)
+{
+    int ci = sm->watchers;
+    while (ci >= 0)
+    {
+        // A failed send closes ci, which unlinks it
+        int next = wk->conns[ci].nextWatcher;
+        Send(wk, ci, type, payload, len);
+        StatAdd(&wk->spectatorBytes, NET_HEADER + len);
+        ci = next;
+    }
+}
+
+// Send spectators whatever changed since the view they have
+static void SyncWatchers(Worker *wk, ServerMatch *sm, double now)
+{
+    MatchView cur;
+    unsigned char buf[VIEW_DELTA_MAX + VIEW_KEYFRAME_MAX];
+    CarouselAdvanceTo(&sm->state.carousel, &sm->state.pool, now);
+    MatchViewCapture(&cur, &sm->state, sm->id, now);
+
+    int len = MatchViewEncodeDelta(&sm->view, &cur, buf);
+    if (len == 0)
+        return; // Carousel motion only; spectators extrapolate that
+    sm->view = cur;
+    if (len > 0)
+        SendToWatchers(wk, sm, MSG_DELTA, buf, len);
+    else
+        SendToWatchers(wk, sm, MSG_KEYFRAME, buf, MatchViewEncodeKeyframe(&cur, buf));
+}
+
+static void Unwatch(Worker *wk, int ci)
+{
+    Conn *c = &wk->conns[ci];
+    ServerMatch *sm = &wk->matches[c->watching];
+    int *link = &sm->watchers;
+    while (*link >= 0 && *link != ci)
+        link = &wk->conns[*link].nextWatcher;
+    if (*link == ci)
+        *link = c->nextWatcher;
+    sm->watcherCount--;
+    c->watching = -1;
+    c->nextWatcher = -1;
+    StatAdd(&wk->spectators, -1);
+}
+
+// Start ci watching a match on this worker, or any live one for id 0
+static void Watch(Worker *wk, int ci, unsigned int matchId)
+{
+    int mi = -1;
+    for (int i = 0; i < wk->matchCap && mi < 0; i++)
+    {
+        if (wk->matches[i].active && (matchId == 0 || wk->matches[i].id == matchId))
+            mi = i;
+    }
+    if (mi < 0)
+    {
+        unsigned char p[4];
+        NetPutU32(p, matchId);
+        Send(wk, ci, MSG_REJECT, p, 4);
+        return;
+    }
+
+    // Existing spectators catch up first, so the keyframe below and the
+    // next delta start from the same view
+    ServerMatch *sm = &wk->matches[mi];
+    double now = Now();
+    SyncWatchers(wk, sm, now);
+    if (!sm->active)
+        return;
+
+    Conn *c = &wk->conns[ci];
+    c->watching = mi;
+    c->nextWatcher = sm->watchers;
+    sm->watchers = ci;
+    sm->watcherCount++;
+    StatAdd(&wk->spectators, 1);
+
+    MatchView cur;
+    unsigned char buf[VIEW_KEYFRAME_MAX];
+    MatchViewCapture(&cur, &sm->state, sm->id, now);
+    if (sm->watcherCount == 1)
+        sm->view = cur;
+    int len = MatchViewEncodeKeyframe(&cur, buf);
+    Send(wk, ci, MSG_KEYFRAME, buf, len);
+    StatAdd(&wk->spectatorBytes, NET_HEADER + len);
+}
+
+static void SweepWatchers(Worker *wk, double now)
+{
+    for (int i = 0; i < wk->matchCap; i++)
+    {
+        ServerMatch *sm = &wk->matches[i];
+        if (sm->active && sm->watcherCount > 0)
+            SyncWatchers(wk, sm, now);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Matches
+//----------------------------------------------------------------------------------
+// winner: seat that won, or -1 for a draw
+static void EndMatch(Worker *wk, ServerMatch *sm, int winner)
+{
+    unsigned char p[5];
+    NetPutU16(p, (unsigned)MatchTotal(&sm->state, 0));
+    NetPutU16(p + 2, (unsigned)MatchTotal(&sm->state, 1));
+    p[4] = (unsigned char)(signed char)winner;
+
+    // Spectators see the final board, then the result
+    if (sm->watcherCount > 0)
+        SyncWatchers(wk, sm, Now());
+    int watcher = sm->watchers;
+    sm->watchers = -1;
+    sm->watcherCount = 0;
+    while (watcher >= 0)
+    {
+        Conn *c = &wk->conns[watcher];
+        int next = c->nextWatcher;
+        c->watching = -1;
+        c->nextWatcher = -1;
+        StatAdd(&wk->spectators, -1);
+        Send(wk, watcher, MSG_OVER, p, 5);
+        watcher = next;
+    }
+
+    // Detach first: a failed send below closes that connection, which
+    // must not find its way back into this match
+    int conns[MATCH_PLAYERS];
+    WheelCancel(&sm->timer);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        conns[s] = sm->conns[s];
+        if (conns[s] >= 0)
+            wk->conns[conns[s]].match = -1;
+    }
+    sm->active = 0;
+    wk->freeMatches[wk->freeMatchCount++] = (int)(sm - wk->matches);
+    StatAdd(&wk->finished, 1);
+    StatAdd(&wk->liveMatches, -1);
+
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        if (conns[s] >= 0)
+            Send(wk, conns[s], MSG_OVER, p, 5);
+    }
+}
+
+static void ArmMatch(Worker *wk, ServerMatch *sm)
+{
+    double deadline = MatchNextDeadline(&sm->state);
+    if (deadline > 0.0)
+        WheelSchedule(&wk->wheel, &sm->timer, deadline);
+}
+
+static void StartMatch(Worker *wk, int a, int b)
+{
+    if (wk->freeMatchCount == 0)
+    {
+        // Shard is full: keep the first player queued, turn the second away
+        wk->waiting = a;
+        CloseConn(wk, b);
+        return;
+    }
+
+    int mi = wk->freeMatches[--wk->freeMatchCount];
+    ServerMatch *sm = &wk->matches[mi];
+    unsigned int seed = (unsigned int)(Now() * 1e6) ^ (mi * 2654435761u);
+    MatchInit(&sm->state, &config, seed, Now());
+    sm->timer.armed = 0;
+    sm->conns[0] = a;
+    sm->conns[1] = b;
+    sm->id = ((unsigned int)wk->index << 24) | (wk->nextMatchSeq++ % 0xFFFFFF + 1); // Never 0: that means "any"
+    sm->active = 1;
+    sm->watchers = -1;
+    sm->watcherCount = 0;
+    StatAdd(&wk->started, 1);
+    StatAdd(&wk->liveMatches, 1);
+
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+    {
+        wk->conns[sm->conns[s]].match = mi;
+        wk->conns[sm->conns[s]].seat = s;
+    }
+    for (int s = 0; s < MATCH_PLAYERS && sm->active; s++)
+    {
+        unsigned char p[9];
+        NetPutU32(p, sm->id);
+        p[4] = (unsigned char)s;
+        NetPutU32(p + 5, seed);
+        Send(wk, sm->conns[s], MSG_WELCOME, p, 9);
+    }
+    if (sm->active)
+        ArmMatch(wk, sm);
+}
+
+static void OnTimer(Worker *wk, TimerNode *n, double now, double deadline)
+{
+    ServerMatch *sm = MatchFromTimer(n);
+
+    double late = now - deadline;
+    int bucket = late <= 0.0 ? 0 : (int)(late / JITTER_BUCKET);
+    StatAdd(&wk->jitter[bucket < JITTER_BUCKETS ? bucket : JITTER_BUCKETS], 1);
+
+    int events = MatchTick(&sm->state, now);
+    if (events & MATCH_EVENT_OVER)
+    {
+        EndMatch(wk, sm, MatchWinner(&sm->state));
+        return;
+    }
+    if (events & MATCH_EVENT_TURN)
+    {
+        unsigned char p[1] = {(unsigned char)sm->state.turn};
+        Broadcast(wk, sm, MSG_TURN, p, 1);
+    }
+    if (sm->active)
+        ArmMatch(wk, sm);
+}
+
+static void WheelAdvance(Worker *wk, double now)
+{
+    TimerWheel *w = &wk->wheel;
+    long long target = (long long)((now - w->origin) / WHEEL_TICK);
+
+    while (w->current < target)
+    {
+        w->current++;
+        TimerNode *head = &w->slots[w->current % WHEEL_SLOTS];
+        TimerNode *n = head->next;
+        while (n != head)
+        {
+            TimerNode *next = n->next;
+            if (n->tick <= w->current)
+            {
+                WheelCancel(n);
+                OnTimer(wk, n, now, n->deadline);
+            }
+            n = next;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Messages
+//----------------------------------------------------------------------------------
+static void OnPick(Worker *wk, int ci, unsigned int seq)
+{
+    Conn *c = &wk->conns[ci];
+    unsigned char p[11];
+
+    if (c->match < 0)
+    {
+        NetPutU32(p, seq);
+        Send(wk, ci, MSG_REJECT, p, 4);
+        return;
+    }
+
+    ServerMatch *sm = &wk->matches[c->match];
+    // The carousel is a function of time, so the server's receive time is
+    // the moment the pick is judged at
+    CardHandle card = CARD_NONE;
+    double now = Now();
+    CarouselAdvanceTo(&sm->state.carousel, &sm->state.pool, now);
+    int zone = CarouselSlotInZone(&sm->state.carousel, config.zoneY, config.cardHeight);
+    if (zone >= 0)
+        card = sm->state.carousel.slots[zone];
+    int defId = card != CARD_NONE ? CardDefId(&sm->state.pool, card) : 0;
+
+    int slot = MatchPick(&sm->state, c->seat, now);
+    if (slot < 0)
+    {
+        NetPutU32(p, seq);
+        Send(wk, ci, MSG_REJECT, p, 4);
+        return;
+    }
+    StatAdd(&wk->picks, 1);
+
+    p[0] = (unsigned char)c->seat;
+    p[1] = (unsigned char)slot;
+    p[2] = (unsigned char)defId;
+    NetPutU32(p + 3, seq);
+    NetPutU16(p + 7, (unsigned)MatchTotal(&sm->state, 0));
+    NetPutU16(p + 9, (unsigned)MatchTotal(&sm->state, 1));
+    Broadcast(wk, sm, MSG_PICKED, p, 11);
+
+    if (config.turnTime > 0)
+    {
+        unsigned char t[1] = {(unsigned char)sm->state.turn};
+        Broadcast(wk, sm, MSG_TURN, t, 1);
+    }
+    if (sm->active)
+        ArmMatch(wk, sm);
+}
+
+static void HandOff(Worker *wk, int fd, unsigned int watch);
+
+// `behind` is how many bytes the client already sent after this request
+static void OnSpectate(Worker *wk, int ci, unsigned int matchId, int behind)
+{
+    Conn *c = &wk->conns[ci];
+    if (c->watching >= 0)
+        Unwatch(wk, ci);
+
+    int owner = (int)(matchId >> 24);
+    if (matchId == 0 || owner == wk->index || owner >= workerCount)
+    {
+        Watch(wk, ci, matchId);
+        return;
+    }
+    if (c->outLen > 0 || behind > 0)
+    {
+        // Unsent output and unread input cannot follow the socket; the
+        // client asks again
+        unsigned char p[4];
+        NetPutU32(p, matchId);
+        Send(wk, ci, MSG_REJECT, p, 4);
+        return;
+    }
+
+    // The match lives on another worker: move the socket there
+    int fd = c->fd;
+    epoll_ctl(wk->epfd, EPOLL_CTL_DEL, fd, NULL);
+    c->fd = -1;
+    wk->freeConns[wk->freeConnCount++] = ci;
+    StatAdd(&wk->liveConns, -1);
+    HandOff(&workers[owner], fd, matchId);
+}
+
+static void OnMessage(Worker *wk, int ci, const unsigned char *msg)
+{
+    Conn *c = &wk->conns[ci];
+    switch (msg[0])
+    {
+    case MSG_JOIN:
+        if (c->match >= 0 || wk->waiting == ci)
+            break;
+        if (c->watching >= 0)
+            Unwatch(wk, ci); // Stops watching to play
+        if (wk->waiting < 0)
+        {
+            wk->waiting = ci;
+        }
+        else
+        {
+            int other = wk->waiting;
+            wk->waiting = -1;
+            StartMatch(wk, other, ci);
+        }
+        break;
+    case MSG_PICK:
+        if (msg[1] >= 4)
+            OnPick(wk, ci, NetGetU32(msg + NET_HEADER));
+        break;
+    case MSG_SPECTATE:
+        if (msg[1] >= 4 && c->match < 0 && wk->waiting != ci)
+            OnSpectate(wk, ci, NetGetU32(msg + NET_HEADER), (int)(c->in + c->inLen - msg) - NET_HEADER - msg[1]);
+        break;
+    default:
+        break;
+    }
+}
+
+static void OnReadable(Worker *wk, int ci)
+{
+    Conn *c = &wk->conns[ci];
+    for (;;)
+    {
+        ssize_t n = recv(c->fd, c->in + c->inLen, CONN_BUF - c->inLen, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            CloseConn(wk, ci);
+            return;
+        }
+        if (n < 0)
+            return;
+        c->inLen += (int)n;
+
+        int off = 0, len;
+        while ((len = NetFrameLength(c->in + off, c->inLen - off)) > 0)
+        {
+            OnMessage(wk, ci, c->in + off);
+            if (c->fd < 0)
+                return;
+            off += len;
+        }
+        memmove(c->in, c->in + off, c->inLen - off);
+        c->inLen -= off;
+    }
+}
+
+static void CloseConn(Worker *wk, int ci)
+{
+    Conn *c = &wk->conns[ci];
+    if (c->fd < 0)
+        return;
+
+    epoll_ctl(wk->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+
+    if (wk->waiting == ci)
+        wk->waiting = -1;
+    if (c->watching >= 0)
+        Unwatch(wk, ci);
+    if (c->match >= 0)
+    {
+        // The seat that stayed wins by forfeit, whatever the score; the
+        // totals are still sent as they stood
+        ServerMatch *sm = &wk->matches[c->match];
+        sm->conns[c->seat] = -1;
+        sm->state.over = 1;
+        EndMatch(wk, sm, 1 - c->seat);
+    }
+    wk->freeConns[wk->freeConnCount++] = ci;
+    StatAdd(&wk->liveConns, -1);
+}
+
+static void AdoptConnections(Worker *wk)
+{
+    unsigned long long count;
+    if (read(wk->wakeFd, &count, sizeof(count)) < 0)
+        return;
+
+    PendingConn pending[INBOX_SIZE];
+    pthread_mutex_lock(&wk->inboxLock);
+    int n = wk->inboxCount;
+    memcpy(pending, wk->inbox, n * sizeof(PendingConn));
+    wk->inboxCount = 0;
+    pthread_mutex_unlock(&wk->inboxLock);
+
+    for (int i = 0; i < n; i++)
+    {
+        if (wk->freeConnCount == 0)
+        {
+            close(pending[i].fd);
+            continue;
+        }
+        int ci = wk->freeConns[--wk->freeConnCount];
+        Conn *c = &wk->conns[ci];
+        memset(c, 0, offsetof(Conn, in));
+        c->fd = pending[i].fd;
+        c->match = -1;
+        c->watching = -1;
+        c->nextWatcher = -1;
+
+        int one = 1;
+        setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        SetNonBlocking(c->fd);
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (unsigned)ci};
+        epoll_ctl(wk->epfd, EPOLL_CTL_ADD, c->fd, &ev);
+        StatAdd(&wk->liveConns, 1);
+        if (pending[i].watch != 0)
+            Watch(wk, ci, pending[i].watch);
+    }
+}
+
+static void *WorkerMain(void *arg)
+{
+    Worker *wk = (Worker *)arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    for (;;)
+    {
+        int n = epoll_wait(wk->epfd, events, MAX_EVENTS, -1);
+        for (int i = 0; i < n; i++)
+        {
+            unsigned int tag = events[i].data.u32;
+            if (tag == TAG_TICK)
+            {
+                unsigned long long expirations;
+                if (read(wk->tickFd, &expirations, sizeof(expirations)) > 0)
+                {
+                    double now = Now();
+                    WheelAdvance(wk, now);
+                    if (now >= wk->nextSpectate)
+                    {
+                        if (wk->spectators > 0)
+                            SweepWatchers(wk, now);
+                        wk->nextSpectate = now + SPECTATE_INTERVAL;
+                    }
+                }
+            }
+            else if (tag == TAG_WAKE)
+            {
+                AdoptConnections(wk);
+            }
+            else
+            {
+                if (wk->conns[tag].fd < 0)
+                    continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    CloseConn(wk, (int)tag);
+                else
+                {
+                    if (events[i].events & EPOLLOUT)
+                        Flush(wk, (int)tag);
+                    if ((events[i].events & EPOLLIN) && wk->conns[tag].fd >= 0)
+                        OnReadable(wk, (int)tag);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static void WorkerInit(Worker *wk, int index, int connCap)
+{
+    memset(wk, 0, sizeof(*wk));
+    wk->index = index;
+    wk->waiting = -1;
+    wk->connCap = connCap;
+    wk->matchCap = connCap / 2 + 1;
+
+    wk->conns = calloc(connCap, sizeof(Conn));
+    wk->freeConns = malloc(connCap * sizeof(int));
+    for (int i = 0; i < connCap; i++)
+    {
+        wk->conns[i].fd = -1;
+        wk->freeConns[i] = connCap - 1 - i;
+    }
+    wk->freeConnCount = connCap;
+
+    wk->matches = calloc(wk->matchCap, sizeof(ServerMatch));
+    wk->freeMatches = malloc(wk->matchCap * sizeof(int));
+    for (int i = 0; i < wk->matchCap; i++)
+        wk->freeMatches[i] = wk->matchCap - 1 - i;
+    wk->freeMatchCount = wk->matchCap;
+
+    pthread_mutex_init(&wk->inboxLock, NULL);
+    WheelInit(&wk->wheel, Now());
+
+    wk->epfd = epoll_create1(0);
+    wk->wakeFd = eventfd(0, EFD_NONBLOCK);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = TAG_WAKE};
+    epoll_ctl(wk->epfd, EPOLL_CTL_ADD, wk->wakeFd, &ev);
+
+    // 1 ms heartbeat drives the wheel, independent of socket traffic
+    wk->tickFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    struct itimerspec its = {{0, (long)(WHEEL_TICK * 1e9)}, {0, (long)(WHEEL_TICK * 1e9)}};
+    timerfd_settime(wk->tickFd, 0, &its, NULL);
+    ev.data.u32 = TAG_TICK;
+    epoll_ctl(wk->epfd, EPOLL_CTL_ADD, wk->tickFd, &ev);
+}
+
+static void HandOff(Worker *wk, int fd, unsigned int watch)
+{
+    pthread_mutex_lock(&wk->inboxLock);
+    int queued = wk->inboxCount < INBOX_SIZE;
+    if (queued)
+    {
+        wk->inbox[wk->inboxCount].fd = fd;
+        wk->inbox[wk->inboxCount].watch = watch;
+        wk->inboxCount++;
+    }
+    pthread_mutex_unlock(&wk->inboxLock);
+
+    if (!queued)
+    {
+        close(fd);
+        return;
+    }
+    unsigned long long one = 1;
+    if (write(wk->wakeFd, &one, sizeof(one)) < 0)
+        perror("eventfd");
+}
+
+//----------------------------------------------------------------------------------
+// Reporting
+//----------------------------------------------------------------------------------
+static void *ReporterMain(void *arg)
+{
+    (void)arg;
+    long long prevJitter[JITTER_BUCKETS + 1] = {0};
+    long long prevPicks = 0, prevFinished = 0, prevSpectatorBytes = 0;
+
+    for (;;)
+    {
+        sleep(REPORT_INTERVAL);
+
+        long long jitter[JITTER_BUCKETS + 1] = {0};
+        long long conns = 0, live = 0, picks = 0, finished = 0, fired = 0, spectators = 0, spectatorBytes = 0;
+        for (int w = 0; w < workerCount; w++)
+        {
+            Worker *wk = &workers[w];
+            for (int b = 0; b <= JITTER_BUCKETS; b++)
+                jitter[b] += __atomic_load_n(&wk->jitter[b], __ATOMIC_RELAXED);
+            conns += __atomic_load_n(&wk->liveConns, __ATOMIC_RELAXED);
+            live += __atomic_load_n(&wk->liveMatches, __ATOMIC_RELAXED);
+            picks += __atomic_load_n(&wk->picks, __ATOMIC_RELAXED);
+            finished += __atomic_load_n(&wk->finished, __ATOMIC_RELAXED);
+            spectators += __atomic_load_n(&wk->spectators, __ATOMIC_RELAXED);
+            spectatorBytes += __atomic_load_n(&wk->spectatorBytes, __ATOMIC_RELAXED);
+        }
+
+        // Lateness of timer firings over the last interval
+        long long delta[JITTER_BUCKETS + 1];
+        for (int b = 0; b <= JITTER_BUCKETS; b++)
+        {
+            delta[b] = jitter[b] - prevJitter[b];
+            prevJitter[b] = jitter[b];
+            fired += delta[b];
+        }
+        double p50 = 0, p99 = 0, max = 0;
+        long long seen = 0;
+        for (int b = 0; b <= JITTER_BUCKETS; b++)
+        {
+            if (delta[b] == 0)
+                continue;
+            seen += delta[b];
+            double us = (b + 1) * JITTER_BUCKET * 1e6;
+            if (p50 == 0 && seen * 2 >= fired)
+                p50 = us;
+            if (p99 == 0 && seen * 100 >= fired * 99)
+                p99 = us;
+            max = us;
+        }
+
+        printf("conns %lld  matches %lld  finished +%lld  picks/s %.0f  timers %lld  late p50<%.0fus p99<%.0fus max<%.0fus%s",
+               conns, live, finished - prevFinished, (double)(picks - prevPicks) / REPORT_INTERVAL,
+               fired, p50, p99, max, delta[JITTER_BUCKETS] ? " (overflow)" : "");
+        if (spectators > 0)
+            printf("  spectators %lld (%.0f B/s each)", spectators,
+                   (double)(spectatorBytes - prevSpectatorBytes) / REPORT_INTERVAL / spectators);
+        printf("\n");
+        fflush(stdout);
+        prevPicks = picks;
+        prevFinished = finished;
+        prevSpectatorBytes = spectatorBytes;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : NET_DEFAULT_PORT;
+    workerCount = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    config = MatchDefaultConfig();
+    if (argc > 3)
+        config.turnTime = (float)atof(argv[3]);
+    if (argc > 4)
+        config.totalTime = (float)atof(argv[4]);
+    int maxConns = argc > 5 ? atoi(argv[5]) : 32768;
+    if (workerCount < 1)
+        workerCount = 1;
+
+    signal(SIGPIPE, SIG_IGN);
+    BoardInitZobrist(); // Once, before workers start creating matches
+    if (EffectInit() != 0)
+        fprintf(stderr, "warning: some card effects did not compile and will do nothing\n");
+
+    // Two sockets per match; lift the descriptor limit as far as allowed
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        if ((long long)rl.rlim_cur < maxConns + 64)
+            fprintf(stderr, "warning: fd limit %lld is below %d connections\n", (long long)rl.rlim_cur, maxConns);
+    }
+
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 4096) < 0)
+    {
+        perror("listen");
+        return 1;
+    }
+
+    workers = calloc(workerCount, sizeof(Worker));
+    for (int w = 0; w < workerCount; w++)
+    {
+        WorkerInit(&workers[w], w, maxConns / workerCount + 1);
+        pthread_create(&workers[w].thread, NULL, WorkerMain, &workers[w]);
+    }
+    pthread_t reporter;
+    pthread_create(&reporter, NULL, ReporterMain, NULL);
+
+    printf("GOWTHER match server on port %d, %d workers, turn %.1fs, game %.1fs, up to %d connections\n",
+           port, workerCount, config.turnTime, config.totalTime, maxConns);
+    fflush(stdout);
+
+    // Deal new connections to workers two at a time, so consecutive players
+    // land on the same worker and can be paired there
+    unsigned long long accepted = 0;
+    for (;;)
+    {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EMFILE || errno == ENFILE)
+                usleep(1000);
+            continue;
+        }
+        HandOff(&workers[(accepted / 2) % workerCount], fd, 0);
+        accepted++;
+    }
+    return 0;
+}
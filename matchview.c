@@ -0,0 +1,327 @@
+#include "matchview.h"
+#include <string.h>
+
+void MatchViewCapture(MatchView *v, const MatchState *m, unsigned int matchId, double now)
+{
+    memset(v, 0, sizeof(*v));
+    v->matchId = matchId;
+    v->headSeq = m->carousel.headSeq;
+    v->offset = CarouselOffset(&m->carousel);
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        CardHandle card = m->carousel.slots[i];
+        v->slots[i] = card != CARD_NONE ? (unsigned char)(CardDefId(&m->pool, card) + 1) : 0;
+    }
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            int count = BoardRowCount(&m->board, s, r);
+            for (int i = 0; i < count; i++)
+                v->rows[s][r][i] = (unsigned char)(CardDefId(&m->pool, m->rows[s][r][i]) + 1);
+            v->rowScores[s][r] = (unsigned short)BoardRowScore(&m->board, s, r);
+        }
+    v->weather = (unsigned char)(m->board.flags & BOARD_WEATHER_MASK);
+    v->turn = (unsigned char)m->turn;
+    v->over = (unsigned char)m->over;
+    v->matchElapsed = (float)(now - m->startTime);
+    v->turnElapsed = (float)(now - m->turnStart);
+    v->speed = m->config.speed;
+    v->pitch = m->config.pitch;
+    v->turnTime = m->config.turnTime;
+    v->totalTime = m->config.totalTime;
+}
+
+// Move a received view forward by dt, the way the server's carousel moves.
+// Cards entering at the bottom are unknown until the next delta names them;
+// they start well below the screen, so the gap is never seen.
+void MatchViewAdvance(MatchView *v, float dt)
+{
+    if (v->over || dt <= 0.0f)
+        return;
+
+    v->matchElapsed += dt;
+    v->turnElapsed += dt;
+    v->offset -= v->speed * dt;
+    while (v->offset < -v->pitch && v->pitch > 0.0f)
+    {
+        v->offset += v->pitch;
+        memmove(v->slots, v->slots + 1, CAROUSEL_SLOTS - 1);
+        v->slots[CAROUSEL_SLOTS - 1] = 0;
+        v->headSeq++;
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Bit packing, least significant bit first
+//----------------------------------------------------------------------------------
+typedef struct
+{
+    unsigned char *p;
+    int bit;
+} BitWriter;
+
+typedef struct
+{
+    const unsigned char *p;
+    int bit;
+    int bits; // Available
+    int error;
+} BitReader;
+
+static void PutBits(BitWriter *w, unsigned int v, int n)
+{
+    for (int i = 0; i < n; i++, w->bit++)
+    {
+        if ((v >> i) & 1)
+            w->p[w->bit >> 3] |= (unsigned char)(1u << (w->bit & 7));
+    }
+}
+
+static unsigned int GetBits(BitReader *r, int n)
+{
+    if (r->bit + n > r->bits)
+    {
+        r->error = 1;
+        return 0;
+    }
+    unsigned int v = 0;
+    for (int i = 0; i < n; i++, r->bit++)
+        v |= (unsigned int)((r->p[r->bit >> 3] >> (r->bit & 7)) & 1) << i;
+    return v;
+}
+
+static unsigned int Quantize(float value, float scale, unsigned int max)
+{
+    float q = value * scale + 0.5f;
+    return q <= 0.0f ? 0 : q >= (float)max ? max : (unsigned int)q;
+}
+
+// Offset in quarter pixels and clocks in tenths of a second. The match
+// clock gets 20 bits (29 hours) since untimed matches run as long as anyone
+// plays; the turn clock never passes the 10-bit turnTime.
+#define OFFSET_BITS 12
+#define CLOCK_BITS 12
+#define MATCH_CLOCK_BITS 20
+#define TOTAL_TIME_BITS 16
+#define SCORE_BITS 12
+#define DEF_BITS 4
+#define ADVANCE_BITS 4
+
+static void PutMotion(BitWriter *w, const MatchView *v)
+{
+    PutBits(w, Quantize(-v->offset, 4.0f, (1u << OFFSET_BITS) - 1), OFFSET_BITS);
+    PutBits(w, Quantize(v->matchElapsed, 10.0f, (1u << MATCH_CLOCK_BITS) - 1), MATCH_CLOCK_BITS);
+    PutBits(w, Quantize(v->turnElapsed, 10.0f, (1u << CLOCK_BITS) - 1), CLOCK_BITS);
+}
+
+static void GetMotion(BitReader *r, MatchView *v)
+{
+    v->offset = -(float)GetBits(r, OFFSET_BITS) / 4.0f;
+    v->matchElapsed = (float)GetBits(r, MATCH_CLOCK_BITS) / 10.0f;
+    v->turnElapsed = (float)GetBits(r, CLOCK_BITS) / 10.0f;
+}
+
+//----------------------------------------------------------------------------------
+// Keyframe: the whole view
+//----------------------------------------------------------------------------------
+int MatchViewEncodeKeyframe(const MatchView *v, unsigned char *out)
+{
+    BitWriter w = {out, 0};
+    memset(out, 0, VIEW_KEYFRAME_MAX);
+
+    PutBits(&w, v->matchId, 32);
+    PutBits(&w, v->headSeq, 32);
+    PutMotion(&w, v);
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+        PutBits(&w, v->slots[i], DEF_BITS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            for (int i = 0; i < MAX_ROW_CARDS; i++)
+                PutBits(&w, v->rows[s][r][i], DEF_BITS);
+            PutBits(&w, v->rowScores[s][r], SCORE_BITS);
+        }
+    PutBits(&w, v->weather, 8);
+    PutBits(&w, v->turn, 1);
+    PutBits(&w, v->over, 1);
+    PutBits(&w, Quantize(v->speed, 16.0f, 0xFFFF), 16);
+    PutBits(&w, Quantize(v->pitch, 4.0f, 0xFFF), 12);
+    PutBits(&w, Quantize(v->turnTime, 10.0f, 0x3FF), 10);
+    PutBits(&w, Quantize(v->totalTime, 10.0f, (1u << TOTAL_TIME_BITS) - 1), TOTAL_TIME_BITS);
+    return (w.bit + 7) >> 3;
+}
+
+int MatchViewDecodeKeyframe(MatchView *v, const unsigned char *in, int len)
+{
+    BitReader r = {in, 0, len * 8, 0};
+    MatchView k;
+    memset(&k, 0, sizeof(k));
+
+    k.matchId = GetBits(&r, 32);
+    k.headSeq = GetBits(&r, 32);
+    GetMotion(&r, &k);
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+        k.slots[i] = (unsigned char)GetBits(&r, DEF_BITS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int ro = 0; ro < MATCH_ROWS; ro++)
+        {
+            for (int i = 0; i < MAX_ROW_CARDS; i++)
+                k.rows[s][ro][i] = (unsigned char)GetBits(&r, DEF_BITS);
+            k.rowScores[s][ro] = (unsigned short)GetBits(&r, SCORE_BITS);
+        }
+    k.weather = (unsigned char)GetBits(&r, 8);
+    k.turn = (unsigned char)GetBits(&r, 1);
+    k.over = (unsigned char)GetBits(&r, 1);
+    k.speed = (float)GetBits(&r, 16) / 16.0f;
+    k.pitch = (float)GetBits(&r, 12) / 4.0f;
+    k.turnTime = (float)GetBits(&r, 10) / 10.0f;
+    k.totalTime = (float)GetBits(&r, TOTAL_TIME_BITS) / 10.0f;
+    if (r.error)
+        return 0;
+    *v = k;
+    return 1;
+}
+
+//----------------------------------------------------------------------------------
+// Delta: carousel advance and motion, then only what changed, each section
+// behind a bit mask
+//----------------------------------------------------------------------------------
+static void ShiftSlots(unsigned char *slots, const unsigned char *from, unsigned int advance)
+{
+    for (unsigned int i = 0; i < CAROUSEL_SLOTS; i++)
+        slots[i] = i + advance < CAROUSEL_SLOTS ? from[i + advance] : 0;
+}
+
+// Returns the encoded size, 0 if nothing but motion changed (no need to
+// send; receivers extrapolate that), or -1 if the change is too large for a
+// delta and a keyframe should go out instead.
+int MatchViewEncodeDelta(const MatchView *prev, const MatchView *cur, unsigned char *out)
+{
+    unsigned int advance = cur->headSeq - prev->headSeq;
+    if (advance >= (1u << ADVANCE_BITS) || prev->matchId != cur->matchId)
+        return -1;
+
+    unsigned char shifted[CAROUSEL_SLOTS];
+    ShiftSlots(shifted, prev->slots, advance);
+
+    unsigned int slotMask = 0, rowMask = 0, scoreMask = 0;
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        if (shifted[i] != cur->slots[i])
+            slotMask |= 1u << i;
+    }
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            int bit = s * MATCH_ROWS + r;
+            if (memcmp(prev->rows[s][r], cur->rows[s][r], MAX_ROW_CARDS) != 0)
+                rowMask |= 1u << bit;
+            if (prev->rowScores[s][r] != cur->rowScores[s][r])
+                scoreMask |= 1u << bit;
+        }
+    int status = prev->weather != cur->weather || prev->turn != cur->turn || prev->over != cur->over;
+
+    if (advance == 0 && !slotMask && !rowMask && !scoreMask && !status)
+        return 0;
+
+    BitWriter w = {out, 0};
+    memset(out, 0, VIEW_DELTA_MAX);
+    PutBits(&w, advance, ADVANCE_BITS);
+    PutMotion(&w, cur);
+
+    PutBits(&w, slotMask, CAROUSEL_SLOTS);
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        if (slotMask & (1u << i))
+            PutBits(&w, cur->slots[i], DEF_BITS);
+    }
+
+    PutBits(&w, rowMask, MATCH_PLAYERS * MATCH_ROWS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            if (!(rowMask & (1u << (s * MATCH_ROWS + r))))
+                continue;
+            unsigned int cardMask = 0;
+            for (int i = 0; i < MAX_ROW_CARDS; i++)
+            {
+                if (prev->rows[s][r][i] != cur->rows[s][r][i])
+                    cardMask |= 1u << i;
+            }
+            PutBits(&w, cardMask, MAX_ROW_CARDS);
+            for (int i = 0; i < MAX_ROW_CARDS; i++)
+            {
+                if (cardMask & (1u << i))
+                    PutBits(&w, cur->rows[s][r][i], DEF_BITS);
+            }
+        }
+
+    PutBits(&w, scoreMask, MATCH_PLAYERS * MATCH_ROWS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int r = 0; r < MATCH_ROWS; r++)
+        {
+            if (scoreMask & (1u << (s * MATCH_ROWS + r)))
+                PutBits(&w, cur->rowScores[s][r], SCORE_BITS);
+        }
+
+    PutBits(&w, status, 1);
+    if (status)
+    {
+        PutBits(&w, cur->weather, 8);
+        PutBits(&w, cur->turn, 1);
+        PutBits(&w, cur->over, 1);
+    }
+    return (w.bit + 7) >> 3;
+}
+
+int MatchViewDecodeDelta(MatchView *v, const unsigned char *in, int len)
+{
+    BitReader r = {in, 0, len * 8, 0};
+    MatchView d = *v;
+
+    unsigned int advance = GetBits(&r, ADVANCE_BITS);
+    ShiftSlots(d.slots, v->slots, advance);
+    d.headSeq += advance;
+    GetMotion(&r, &d);
+
+    unsigned int slotMask = GetBits(&r, CAROUSEL_SLOTS);
+    for (int i = 0; i < CAROUSEL_SLOTS; i++)
+    {
+        if (slotMask & (1u << i))
+            d.slots[i] = (unsigned char)GetBits(&r, DEF_BITS);
+    }
+
+    unsigned int rowMask = GetBits(&r, MATCH_PLAYERS * MATCH_ROWS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int ro = 0; ro < MATCH_ROWS; ro++)
+        {
+            if (!(rowMask & (1u << (s * MATCH_ROWS + ro))))
+                continue;
+            unsigned int cardMask = GetBits(&r, MAX_ROW_CARDS);
+            for (int i = 0; i < MAX_ROW_CARDS; i++)
+            {
+                if (cardMask & (1u << i))
+                    d.rows[s][ro][i] = (unsigned char)GetBits(&r, DEF_BITS);
+            }
+        }
+
+    unsigned int scoreMask = GetBits(&r, MATCH_PLAYERS * MATCH_ROWS);
+    for (int s = 0; s < MATCH_PLAYERS; s++)
+        for (int ro = 0; ro < MATCH_ROWS; ro++)
+        {
+            if (scoreMask & (1u << (s * MATCH_ROWS + ro)))
+                d.rowScores[s][ro] = (unsigned short)GetBits(&r, SCORE_BITS);
+        }
+
+    if (GetBits(&r, 1))
+    {
+        d.weather = (unsigned char)GetBits(&r, 8);
+        d.turn = (unsigned char)GetBits(&r, 1);
+        d.over = (unsigned char)GetBits(&r, 1);
+    }
+
+    if (r.error)
+        return 0;
+    *v = d;
+    return 1;
+}
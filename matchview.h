@@ -0,0 +1,47 @@
+#ifndef MATCHVIEW_H
+#define MATCHVIEW_H
+
+#include "match.h"
+
+// Everything needed to draw a match, and nothing needed to run one. The game
+// draws from a view captured every frame; spectators receive one as a
+// bit-packed keyframe and then keep it up to date from deltas, extrapolating
+// the carousel and clocks in between.
+
+#define VIEW_DELTA_MAX 96     // Bytes, worst case for one encoded delta
+#define VIEW_KEYFRAME_MAX 64  // Bytes for an encoded keyframe
+
+#if CARD_DEF_COUNT > 15
+#error "matchview encodes card definitions in 4 bits"
+#endif
+
+typedef struct
+{
+    unsigned int matchId;
+    unsigned int headSeq;
+    float offset;                                                 // CarouselOffset, [-pitch, 0]
+    unsigned char slots[CAROUSEL_SLOTS];                          // Def id + 1, 0 = empty
+    unsigned char rows[MATCH_PLAYERS][MATCH_ROWS][MAX_ROW_CARDS]; // Def id + 1, 0 = empty
+    unsigned short rowScores[MATCH_PLAYERS][MATCH_ROWS];
+    unsigned char weather;
+    unsigned char turn;
+    unsigned char over;
+    float matchElapsed;
+    float turnElapsed;
+
+    // Fixed for the whole match
+    float speed;
+    float pitch;
+    float turnTime;
+    float totalTime;
+} MatchView;
+
+void MatchViewCapture(MatchView *v, const MatchState *m, unsigned int matchId, double now);
+void MatchViewAdvance(MatchView *v, float dt);
+
+int MatchViewEncodeKeyframe(const MatchView *v, unsigned char *out);
+int MatchViewEncodeDelta(const MatchView *prev, const MatchView *cur, unsigned char *out);
+int MatchViewDecodeKeyframe(MatchView *v, const unsigned char *in, int len);
+int MatchViewDecodeDelta(MatchView *v, const unsigned char *in, int len);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef NETPROTO_H
+#define NETPROTO_H
+
+// Wire format shared by the match server and its clients. Every message is
+// [type:u8][length:u8][payload], multi-byte fields little-endian.
+
+#define NET_DEFAULT_PORT 7777
+#define NET_HEADER 2
+#define NET_MAX_PAYLOAD 255
+
+// Client -> server
+#define MSG_JOIN 1 // Queue for the next free opponent
+#define MSG_PICK 2 // seq:u32, take the card in the zone now
+#define MSG_SPECTATE 3 // matchId:u32, watch instead of play (0 = any live match)
+
+// Server -> client
+#define MSG_WELCOME 16 // matchId:u32 seat:u8 seed:u32
+#define MSG_PICKED 17  // seat:u8 slot:u8 defId:u8 seq:u32 total0:u16 total1:u16
+#define MSG_REJECT 18  // seq:u32, or the matchId of a refused MSG_SPECTATE
+#define MSG_TURN 19    // seat:u8
+#define MSG_OVER 20    // total0:u16 total1:u16 winner:i8 (-1 draw)
+#define MSG_KEYFRAME 21 // Whole MatchView, bit-packed (matchview.c)
+#define MSG_DELTA 22    // MatchView changes since the last keyframe or delta
+
+static inline void NetPutU16(unsigned char *p, unsigned int v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline void NetPutU32(unsigned char *p, unsigned int v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static inline unsigned int NetGetU16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline unsigned int NetGetU32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+// Length of the first complete message in buf, 0 if it has not all arrived
+static inline int NetFrameLength(const unsigned char *buf, int len)
+{
+    if (len < NET_HEADER || len < NET_HEADER + buf[1])
+        return 0;
+    return NET_HEADER + buf[1];
+}
+
+#endif
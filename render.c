@@ -0,0 +1,341 @@
+#include "render.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_LAYER_SHIFT 48
+#define KEY_SPRITE_SHIFT 32
+
+static RenderCommand *Push(RenderList *list, int kind, int layer, int sprite)
+{
+    if (list->count >= RENDER_MAX_COMMANDS)
+    {
+        list->dropped++;
+        return NULL;
+    }
+    RenderCommand *c = &list->commands[list->count];
+    c->key = ((unsigned long long)(layer & 0xFF) << KEY_LAYER_SHIFT) |
+             ((unsigned long long)(sprite & 0xFFFF) << KEY_SPRITE_SHIFT) | (unsigned int)list->count;
+    c->kind = (unsigned char)kind;
+    c->layer = (unsigned char)layer;
+    c->sprite = (unsigned short)sprite;
+    c->rotation = 0.0f;
+    c->scale = list->scale;
+    c->text = 0;
+    c->clip = (unsigned char)list->clip;
+    list->count++;
+    list->sorted = 0;
+    return c;
+}
+
+static Rectangle Transform(const RenderList *list, Rectangle r)
+{
+    return (Rectangle){list->origin.x + r.x * list->scale, list->origin.y + r.y * list->scale, r.width * list->scale,
+                       r.height * list->scale};
+}
+
+void RenderListClear(RenderList *list)
+{
+    list->count = 0;
+    list->textUsed = 0;
+    list->dropped = 0;
+    list->sorted = 1;
+    list->clipCount = 0;
+    RenderListSetTransform(list, 0, 0, 1.0f);
+}
+
+void RenderListSetTransform(RenderList *list, float x, float y, float scale)
+{
+    list->origin = (Vector2){x, y};
+    list->scale = scale;
+    list->clip = 0;
+}
+
+void RenderListSetClip(RenderList *list, Rectangle rect)
+{
+    if (rect.width <= 0 || rect.height <= 0)
+    {
+        list->clip = 0;
+        return;
+    }
+    if (list->clipCount >= RENDER_MAX_CLIPS)
+    {
+        list->dropped++; // Commands go unclipped
+        list->clip = 0;
+        return;
+    }
+    list->clips[list->clipCount++] = Transform(list, rect);
+    list->clip = list->clipCount;
+}
+
+void RenderSprite(RenderList *list, int layer, int sprite, float x, float y, Color tint)
+{
+    RenderSpriteEx(list, layer, sprite, (Rectangle){x, y, 0, 0}, 0.0f, tint);
+}
+
+void RenderSpriteEx(RenderList *list, int layer, int sprite, Rectangle dest, float rotation, Color tint)
+{
+    RenderCommand *c = Push(list, RENDER_CMD_SPRITE, layer, sprite);
+    if (c == NULL)
+        return;
+    c->dest = Transform(list, dest);
+    c->rotation = rotation;
+    c->tint = tint;
+}
+
+void RenderText(RenderList *list, int layer, float x, float y, int fontSize, Color color, const char *fmt, ...)
+{
+    int room = RENDER_TEXT_BYTES - list->textUsed;
+    if (room <= 1)
+    {
+        list->dropped++;
+        return;
+    }
+    char *dst = list->text + list->textUsed;
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(dst, room, fmt, args);
+    va_end(args);
+    if (len < 0)
+        return;
+    if (len >= room)
+        len = room - 1; // Truncated
+
+    RenderCommand *c = Push(list, RENDER_CMD_TEXT, layer, RENDER_TEXT_SPRITE);
+    if (c == NULL)
+        return;
+    c->dest = Transform(list, (Rectangle){x, y, (float)fontSize, 0});
+    c->tint = color;
+    c->text = (unsigned short)list->textUsed;
+    list->textUsed += len + 1;
+}
+
+void RenderRect(RenderList *list, int layer, Rectangle rect, Color color)
+{
+    RenderCommand *c = Push(list, RENDER_CMD_RECT, layer, RENDER_NO_SPRITE);
+    if (c == NULL)
+        return;
+    c->dest = Transform(list, rect);
+    c->tint = color;
+}
+
+static int CompareCommands(const void *a, const void *b)
+{
+    unsigned long long ka = ((const RenderCommand *)a)->key;
+    unsigned long long kb = ((const RenderCommand *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Submission order is the low bits of the key, so equal layer and sprite
+// keep the order they were added in
+void RenderListSort(RenderList *list)
+{
+    if (!list->sorted)
+        qsort(list->commands, list->count, sizeof(RenderCommand), CompareCommands);
+    list->sorted = 1;
+}
+
+// Trims dest to the clip rectangle and src by the same fraction. Returns 0
+// if nothing is left.
+static int Clip(Rectangle clip, Rectangle *dest, Rectangle *src)
+{
+    float x0 = dest->x > clip.x ? dest->x : clip.x;
+    float y0 = dest->y > clip.y ? dest->y : clip.y;
+    float x1 = dest->x + dest->width < clip.x + clip.width ? dest->x + dest->width : clip.x + clip.width;
+    float y1 = dest->y + dest->height < clip.y + clip.height ? dest->y + dest->height : clip.y + clip.height;
+    if (x1 <= x0 || y1 <= y0)
+        return 0;
+    if (src != NULL)
+    {
+        float sx = src->width / dest->width, sy = src->height / dest->height;
+        *src = (Rectangle){src->x + (x0 - dest->x) * sx, src->y + (y0 - dest->y) * sy, (x1 - x0) * sx,
+                           (y1 - y0) * sy};
+    }
+    *dest = (Rectangle){x0, y0, x1 - x0, y1 - y0};
+    return 1;
+}
+
+RenderStats RenderListSubmit(const RenderList *list, const Texture2D *sprites, int spriteCount)
+{
+    RenderStats stats = {0};
+    stats.dropped = list->dropped;
+    int lastSprite = -1;
+
+    for (int i = 0; i < list->count; i++)
+    {
+        const RenderCommand *c = &list->commands[i];
+        switch (c->kind)
+        {
+        case RENDER_CMD_SPRITE:
+        {
+            if (c->sprite >= spriteCount || sprites[c->sprite].id == 0)
+                continue;
+            Texture2D tex = sprites[c->sprite];
+            Rectangle dest = c->dest;
+            Rectangle src = {0, 0, (float)tex.width, (float)tex.height};
+            if (dest.width == 0 && dest.height == 0)
+            {
+                dest.width = tex.width * c->scale;
+                dest.height = tex.height * c->scale;
+            }
+            if (c->clip != 0 && c->rotation == 0.0f && !Clip(list->clips[c->clip - 1], &dest, &src))
+                continue;
+            DrawTexturePro(tex, src, dest, (Vector2){0, 0}, c->rotation, c->tint);
+            break;
+        }
+        case RENDER_CMD_TEXT:
+        {
+            int size = (int)(c->dest.width + 0.5f);
+            DrawText(list->text + c->text, (int)c->dest.x, (int)c->dest.y, size > 1 ? size : 1, c->tint);
+            break;
+        }
+        case RENDER_CMD_RECT:
+        {
+            Rectangle dest = c->dest;
+            if (c->clip != 0 && !Clip(list->clips[c->clip - 1], &dest, NULL))
+                continue;
+            DrawRectangleRec(dest, c->tint);
+            break;
+        }
+        default:
+            continue;
+        }
+        stats.commands++;
+        if (c->sprite != lastSprite)
+        {
+            stats.textureSwitches++;
+            lastSprite = c->sprite;
+        }
+    }
+    return stats;
+}
+
+//----------------------------------------------------------------------------------
+// Pipeline
+//----------------------------------------------------------------------------------
+static struct
+{
+    int running;
+    RenderUpdateFn update;
+    void *user;
+    RenderList lists[2];
+    int back;  // List the worker fills
+    int fresh; // The back list holds an update not yet handed out
+    int busy;  // Worker has an update in flight
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t worker;
+    RenderPipelineStats stats;
+} pipe_;
+
+static void *WorkerMain(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&pipe_.lock);
+    for (;;)
+    {
+        while (!pipe_.busy && !pipe_.stopping)
+            pthread_cond_wait(&pipe_.wake, &pipe_.lock);
+        if (pipe_.stopping)
+            break;
+        RenderList *list = &pipe_.lists[pipe_.back];
+        pthread_mutex_unlock(&pipe_.lock);
+
+        double start = GetTime();
+        RenderListClear(list);
+        pipe_.update(pipe_.user, list);
+        RenderListSort(list);
+        float ms = (float)((GetTime() - start) * 1000.0);
+
+        pthread_mutex_lock(&pipe_.lock);
+        pipe_.stats.updateMs = ms;
+        pipe_.fresh = 1;
+        pipe_.busy = 0;
+        pthread_cond_signal(&pipe_.done);
+    }
+    pthread_mutex_unlock(&pipe_.lock);
+    return NULL;
+}
+
+int RenderPipelineStart(RenderUpdateFn update, void *user)
+{
+    if (pipe_.running)
+        return 1;
+    memset(&pipe_, 0, sizeof(pipe_));
+    pipe_.update = update;
+    pipe_.user = user;
+    pthread_mutex_init(&pipe_.lock, NULL);
+    pthread_cond_init(&pipe_.wake, NULL);
+    pthread_cond_init(&pipe_.done, NULL);
+    if (pthread_create(&pipe_.worker, NULL, WorkerMain, NULL) != 0)
+    {
+        pthread_mutex_destroy(&pipe_.lock);
+        pthread_cond_destroy(&pipe_.wake);
+        pthread_cond_destroy(&pipe_.done);
+        return 0;
+    }
+    pipe_.running = 1;
+    return 1;
+}
+
+void RenderPipelineStop(void)
+{
+    if (!pipe_.running)
+        return;
+    pthread_mutex_lock(&pipe_.lock);
+    while (pipe_.busy)
+        pthread_cond_wait(&pipe_.done, &pipe_.lock);
+    pipe_.stopping = 1;
+    pthread_cond_signal(&pipe_.wake);
+    pthread_mutex_unlock(&pipe_.lock);
+    pthread_join(pipe_.worker, NULL);
+
+    pthread_mutex_destroy(&pipe_.lock);
+    pthread_cond_destroy(&pipe_.wake);
+    pthread_cond_destroy(&pipe_.done);
+    pipe_.running = 0;
+}
+
+const RenderList *RenderPipelineWait(void)
+{
+    if (!pipe_.running)
+        return NULL;
+    double start = GetTime();
+    pthread_mutex_lock(&pipe_.lock);
+    while (pipe_.busy)
+        pthread_cond_wait(&pipe_.done, &pipe_.lock);
+    if (pipe_.fresh)
+    {
+        pipe_.back ^= 1;
+        pipe_.fresh = 0;
+        pipe_.stats.frames++;
+    }
+    const RenderList *front = pipe_.stats.frames > 0 ? &pipe_.lists[pipe_.back ^ 1] : NULL;
+    pipe_.stats.waitMs = (float)((GetTime() - start) * 1000.0);
+    pthread_mutex_unlock(&pipe_.lock);
+    return front;
+}
+
+void RenderPipelineKick(void)
+{
+    if (!pipe_.running)
+        return;
+    pthread_mutex_lock(&pipe_.lock);
+    pipe_.busy = 1;
+    pthread_cond_signal(&pipe_.wake);
+    pthread_mutex_unlock(&pipe_.lock);
+}
+
+RenderPipelineStats RenderPipelineGetStats(void)
+{
+    if (!pipe_.running)
+        return pipe_.stats;
+    pthread_mutex_lock(&pipe_.lock);
+    RenderPipelineStats stats = pipe_.stats;
+    pthread_mutex_unlock(&pipe_.lock);
+    return stats;
+}
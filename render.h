@@ -0,0 +1,112 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "raylib.h"
+
+// Render command lists. Game code describes a frame as a list of sprite, text
+// and rectangle commands instead of calling raylib directly; the list is
+// sorted by layer and then by texture so raylib's batcher sees as few texture
+// switches as possible, and can be inspected (counts, dumps) before it is
+// submitted.
+//
+// Building a list touches no GL state: sprites are small integers resolved
+// against a texture table only at submit time, and text is formatted into the
+// list itself rather than through TextFormat's shared buffers. That lets the
+// render pipeline build frame N+1 on a worker thread while the main thread,
+// which owns the GL context, submits frame N.
+//
+// Within a layer, commands on different textures may be reordered; anything
+// that must be drawn over something else goes on a higher layer.
+//
+// A transform (offset and scale) and a clip rectangle can be set on the list;
+// they apply to the commands added after them. Several scaled-down screens
+// can share one list that way and still draw each texture in one run.
+
+#define RENDER_MAX_COMMANDS 4096
+#define RENDER_TEXT_BYTES 16384
+#define RENDER_MAX_LAYERS 256
+#define RENDER_MAX_CLIPS 255
+#define RENDER_NO_SPRITE 0xFFFF // Rectangles
+#define RENDER_TEXT_SPRITE 0xFFFE // Text, drawn after sprites in its layer
+
+typedef enum
+{
+    RENDER_CMD_SPRITE,
+    RENDER_CMD_TEXT,
+    RENDER_CMD_RECT
+} RenderCommandKind;
+
+typedef struct
+{
+    unsigned long long key; // Layer, sprite, then submission order
+    unsigned char kind;     // RenderCommandKind
+    unsigned char layer;
+    unsigned short sprite;  // Index into the submit texture table
+    Rectangle dest;         // Sprites: width/height 0 = texture size. Text: width is the font size
+    float rotation;         // Degrees, about the top-left corner
+    float scale;            // Applied to the texture size when dest has none
+    Color tint;
+    unsigned short text;    // Offset into the list's text buffer
+    unsigned char clip;     // Clip rectangle + 1, 0 = none. Not applied to rotated sprites or text
+} RenderCommand;
+
+typedef struct
+{
+    RenderCommand commands[RENDER_MAX_COMMANDS];
+    int count;
+    char text[RENDER_TEXT_BYTES];
+    int textUsed;
+    int dropped; // Commands that did not fit
+    int sorted;
+
+    // Applied to commands as they are added
+    Vector2 origin;
+    float scale;
+    int clip;
+    Rectangle clips[RENDER_MAX_CLIPS]; // Screen coordinates
+    int clipCount;
+} RenderList;
+
+typedef struct
+{
+    int commands;
+    int textureSwitches; // Changes of texture between consecutive commands
+    int dropped;
+} RenderStats;
+
+void RenderListClear(RenderList *list);
+void RenderListSetTransform(RenderList *list, float x, float y, float scale); // Also drops the clip
+void RenderListSetClip(RenderList *list, Rectangle rect); // Untransformed coordinates
+void RenderSprite(RenderList *list, int layer, int sprite, float x, float y, Color tint);
+void RenderSpriteEx(RenderList *list, int layer, int sprite, Rectangle dest, float rotation, Color tint);
+void RenderText(RenderList *list, int layer, float x, float y, int fontSize, Color color, const char *fmt, ...);
+void RenderRect(RenderList *list, int layer, Rectangle rect, Color color);
+void RenderListSort(RenderList *list);
+RenderStats RenderListSubmit(const RenderList *list, const Texture2D *sprites, int spriteCount); // GL thread
+
+// Render pipeline: update(user, list) runs on a worker thread and fills one
+// list while the caller submits the other. Per frame, on the main thread:
+//
+//     list = RenderPipelineWait();   // update N-1 done, its list is now ours
+//     ...exchange input and results with the update state...
+//     RenderPipelineKick();          // update N starts on the worker
+//     RenderListSubmit(list, ...);   // GPU work for N-1 overlaps update N
+//
+// The update state may only be touched between Wait and Kick. The list
+// returned by Wait stays valid until the next Wait.
+typedef void (*RenderUpdateFn)(void *user, RenderList *out);
+
+typedef struct
+{
+    float updateMs; // Worker time for the last update
+    float waitMs;   // Main thread time blocked in the last Wait
+    unsigned int frames;
+} RenderPipelineStats;
+
+int RenderPipelineStart(RenderUpdateFn update, void *user);
+void RenderPipelineStop(void);
+const RenderList *RenderPipelineWait(void); // NULL before the first update has run
+void RenderPipelineKick(void);
+RenderPipelineStats RenderPipelineGetStats(void);
+
+#endif
@@ -0,0 +1,96 @@
+#include "replay.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int seed;
+    unsigned int pad;
+} ReplayHeader;
+
+static FILE *recordFile = NULL;
+static FILE *playFile = NULL;
+
+int ReplayRecordStart(const char *path, unsigned int seed)
+{
+    ReplayRecordStop();
+    recordFile = fopen(path, "wb");
+    if (recordFile == NULL)
+        return 0;
+    ReplayHeader h = {{0}, REPLAY_VERSION, seed, 0};
+    memcpy(h.magic, REPLAY_MAGIC, 4);
+    fwrite(&h, sizeof(h), 1, recordFile);
+    return 1;
+}
+
+void ReplayRecordFrame(const ReplayFrame *frame)
+{
+    if (recordFile == NULL)
+        return;
+    unsigned char flags[3] = {(unsigned char)frame->click, (unsigned char)frame->back,
+                              (unsigned char)frame->pressCount};
+    fwrite(&frame->now, sizeof(frame->now), 1, recordFile);
+    fwrite(&frame->mouseX, sizeof(frame->mouseX), 1, recordFile);
+    fwrite(&frame->mouseY, sizeof(frame->mouseY), 1, recordFile);
+    fwrite(flags, sizeof(flags), 1, recordFile);
+    for (int i = 0; i < frame->pressCount; i++)
+    {
+        fwrite(&frame->presses[i].time, sizeof(double), 1, recordFile);
+        fwrite(&frame->presses[i].key, sizeof(int), 1, recordFile);
+    }
+}
+
+void ReplayRecordStop(void)
+{
+    if (recordFile != NULL)
+        fclose(recordFile);
+    recordFile = NULL;
+}
+
+int ReplayOpen(const char *path, unsigned int *seed)
+{
+    ReplayClose();
+    playFile = fopen(path, "rb");
+    if (playFile == NULL)
+        return 0;
+    ReplayHeader h;
+    if (fread(&h, sizeof(h), 1, playFile) != 1 || memcmp(h.magic, REPLAY_MAGIC, 4) != 0 ||
+        h.version != REPLAY_VERSION)
+    {
+        ReplayClose();
+        return 0;
+    }
+    *seed = h.seed;
+    return 1;
+}
+
+int ReplayNextFrame(ReplayFrame *frame)
+{
+    if (playFile == NULL)
+        return 0;
+    unsigned char flags[3];
+    if (fread(&frame->now, sizeof(frame->now), 1, playFile) != 1 ||
+        fread(&frame->mouseX, sizeof(frame->mouseX), 1, playFile) != 1 ||
+        fread(&frame->mouseY, sizeof(frame->mouseY), 1, playFile) != 1 ||
+        fread(flags, sizeof(flags), 1, playFile) != 1 || flags[2] > INPUT_QUEUE_SIZE)
+        return 0;
+    frame->click = flags[0];
+    frame->back = flags[1];
+    frame->pressCount = flags[2];
+    for (int i = 0; i < frame->pressCount; i++)
+    {
+        if (fread(&frame->presses[i].time, sizeof(double), 1, playFile) != 1 ||
+            fread(&frame->presses[i].key, sizeof(int), 1, playFile) != 1)
+            return 0; // Torn last frame
+    }
+    return 1;
+}
+
+void ReplayClose(void)
+{
+    if (playFile != NULL)
+        fclose(playFile);
+    playFile = NULL;
+}
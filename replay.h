@@ -0,0 +1,39 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "input.h"
+
+// Session recording. Everything the game update reads from the outside world
+// each frame - the clock, the mouse, key presses with their timestamps - is
+// written to a file together with the match seed, so a session played back
+// through the same update reproduces every match exactly. Playback hands the
+// recorded clock to the game, which is what lets it run uncapped for
+// benchmarking.
+//
+// File: header {magic, version, seed}, then one frame after another:
+// now f64, mouse x/y f32, click u8, back u8, press count u8, then the
+// presses as {time f64, key i32}. Little-endian, as written by the host.
+
+#define REPLAY_MAGIC "GWRP"
+#define REPLAY_VERSION 1
+
+typedef struct
+{
+    double now;
+    float mouseX;
+    float mouseY;
+    int click; // Left button went down this frame
+    int back;  // Backspace went down this frame
+    InputEvent presses[INPUT_QUEUE_SIZE];
+    int pressCount;
+} ReplayFrame;
+
+int ReplayRecordStart(const char *path, unsigned int seed);
+void ReplayRecordFrame(const ReplayFrame *frame); // Does nothing unless recording
+void ReplayRecordStop(void);
+
+int ReplayOpen(const char *path, unsigned int *seed);
+int ReplayNextFrame(ReplayFrame *frame); // 0 at the end of the recording
+void ReplayClose(void);
+
+#endif
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Frame-time regression check. Plays every recorded session in the corpus
+# (*.gwr, made with `main_game --record file`) through the full game under a
+# virtual X server with software GL, uncapped, and compares frame time, CPU
+# time and peak memory against the baseline stored next to each recording.
+#
+# usage: replay_bench.sh [corpus dir] [--update]
+#   --update   (re)write the baselines instead of checking against them
+#
+# The corpus starts out empty, and an empty corpus passes. To add a session,
+# play it with `./game --record replays/name.gwr`, then run the script once:
+# a recording with no .baseline gets one written from this machine.
+#
+# Environment: GAME (default ./game, what `make` builds), MAX_TIME / MAX_MEM
+# percentages (default 10 / 5).
+
+CORPUS=${1:-replays}
+UPDATE=0
+[ "$2" = "--update" ] && UPDATE=1
+GAME=${GAME:-./game}
+MAX_TIME=${MAX_TIME:-10}
+MAX_MEM=${MAX_MEM:-5}
+
+# llvmpipe, so results do not depend on whatever GPU the machine has
+export LIBGL_ALWAYS_SOFTWARE=1
+run() {
+    xvfb-run -a -s "-screen 0 1366x768x24" "$GAME" "$@"
+}
+
+if ! ls "$CORPUS"/*.gwr >/dev/null 2>&1; then
+    echo "no recordings in $CORPUS, nothing to check"
+    echo "record one with: $GAME --record $CORPUS/name.gwr"
+    exit 0
+fi
+
+if [ ! -x "$GAME" ]; then
+    echo "no game binary at $GAME"
+    exit 2
+fi
+
+status=0
+count=0
+for replay in "$CORPUS"/*.gwr; do
+    [ -e "$replay" ] || continue
+    count=$((count + 1))
+    baseline="${replay%.gwr}.baseline"
+    echo "== $replay"
+    if [ $UPDATE -eq 1 ] || [ ! -e "$baseline" ]; then
+        if run --replay "$replay" --bench-out "$baseline" >/dev/null 2>&1 && [ -e "$baseline" ]; then
+            cat "$baseline"
+        else
+            echo "could not write $baseline"
+            status=1
+        fi
+    else
+        result="${replay%.gwr}.last"
+        run --replay "$replay" --bench-out "$result" --baseline "$baseline" \
+            --max-time "$MAX_TIME" --max-mem "$MAX_MEM" 2>/dev/null
+        code=$?
+        [ $code -ne 0 ] && status=1
+        [ $code -eq 1 ] && echo "REGRESSION in $replay"
+    fi
+done
+
+echo "$count recording(s) checked"
+exit $status
@@ -0,0 +1,347 @@
+#include "resources.h"
+#include <stdio.h>
+#include <string.h>
+
+// raylib keeps two sub-buffers per music stream; this is the default frame
+// count of one sub-buffer on desktop, used to estimate what a stream holds.
+#define RES_MUSIC_SUBBUFFER_FRAMES 4096
+
+typedef struct
+{
+    int used;
+    unsigned short generation;
+    ResourceKind kind;
+    ResourceScope scope;
+    int refs;
+    size_t bytes;
+    char key[RES_MAX_PATH + 4]; // path, plus "|cw" for rotated textures
+    union
+    {
+        Image image;
+        Texture2D texture;
+        Music music;
+    } as;
+} ResourceEntry;
+
+static ResourceEntry entries[RES_MAX_ENTRIES];
+static ResourceReport report;
+static int overBudgetLogged = 0;
+
+static const char *kindNames[RES_KIND_COUNT] = {"images", "textures", "music"};
+static const char *scopeNames[SCOPE_COUNT] = {"global", "match", "screen"};
+
+static ResourceHandle MakeHandle(int slot)
+{
+    ResourceHandle h = {((unsigned int)entries[slot].generation << 16) | (unsigned int)(slot + 1)};
+    return h;
+}
+
+static ResourceEntry *Lookup(ResourceHandle h)
+{
+    int slot = (int)(h.id & 0xFFFF) - 1;
+    if (slot < 0 || slot >= RES_MAX_ENTRIES)
+        return NULL;
+    ResourceEntry *e = &entries[slot];
+    if (!e->used || e->generation != (unsigned short)(h.id >> 16))
+        return NULL;
+    return e;
+}
+
+static int FindSlot(ResourceKind kind, const char *key)
+{
+    for (int i = 0; i < RES_MAX_ENTRIES; i++)
+    {
+        if (entries[i].used && entries[i].kind == kind && strcmp(entries[i].key, key) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int FreeSlot(void)
+{
+    for (int i = 0; i < RES_MAX_ENTRIES; i++)
+    {
+        if (!entries[i].used)
+            return i;
+    }
+    TraceLog(LOG_ERROR, "RES: Registry full (%d entries)", RES_MAX_ENTRIES);
+    return -1;
+}
+
+// Reuse an existing entry for the same file. A request from a longer-lived
+// scope promotes the entry so a screen release cannot pull it from under us.
+static ResourceHandle Share(int slot, ResourceScope scope)
+{
+    ResourceEntry *e = &entries[slot];
+    e->refs++;
+    if (scope < e->scope)
+    {
+        report.scopeBytes[e->scope] -= e->bytes;
+        report.scopeBytes[scope] += e->bytes;
+        e->scope = scope;
+    }
+    return MakeHandle(slot);
+}
+
+static void Account(ResourceEntry *e, int sign)
+{
+    if (sign > 0)
+    {
+        report.kindBytes[e->kind] += e->bytes;
+        report.scopeBytes[e->scope] += e->bytes;
+        report.kindCount[e->kind]++;
+        report.totalBytes += e->bytes;
+        if (report.totalBytes > report.peakBytes)
+            report.peakBytes = report.totalBytes;
+
+        if (report.budgetBytes > 0 && report.totalBytes > report.budgetBytes && !overBudgetLogged)
+        {
+            TraceLog(LOG_WARNING, "RES: Memory budget exceeded (%zu / %zu KB) loading %s",
+                     report.totalBytes / 1024, report.budgetBytes / 1024, e->key);
+            overBudgetLogged = 1;
+        }
+    }
+    else
+    {
+        report.kindBytes[e->kind] -= e->bytes;
+        report.scopeBytes[e->scope] -= e->bytes;
+        report.kindCount[e->kind]--;
+        report.totalBytes -= e->bytes;
+        if (report.totalBytes <= report.budgetBytes)
+            overBudgetLogged = 0;
+    }
+}
+
+static ResourceHandle Commit(int slot, ResourceKind kind, ResourceScope scope, const char *key, size_t bytes)
+{
+    ResourceEntry *e = &entries[slot];
+    e->used = 1;
+    e->kind = kind;
+    e->scope = scope;
+    e->refs = 1;
+    e->bytes = bytes;
+    snprintf(e->key, sizeof(e->key), "%s", key);
+    Account(e, 1);
+    return MakeHandle(slot);
+}
+
+static void Unload(ResourceEntry *e)
+{
+    switch (e->kind)
+    {
+    case RES_IMAGE:
+        UnloadImage(e->as.image);
+        break;
+    case RES_TEXTURE:
+        UnloadTexture(e->as.texture);
+        break;
+    case RES_MUSIC:
+        UnloadMusicStream(e->as.music);
+        break;
+    default:
+        break;
+    }
+    Account(e, -1);
+    e->used = 0;
+    e->refs = 0;
+    e->generation++; // Invalidate outstanding handles
+}
+
+void ResInit(size_t budgetBytes)
+{
+    memset(entries, 0, sizeof(entries));
+    memset(&report, 0, sizeof(report));
+    report.budgetBytes = budgetBytes;
+    overBudgetLogged = 0;
+}
+
+void ResShutdown(void)
+{
+    for (int s = SCOPE_COUNT - 1; s >= 0; s--)
+        ResReleaseScope((ResourceScope)s);
+}
+
+ResourceHandle ResLoadImage(const char *path, ResourceScope scope)
+{
+    int slot = FindSlot(RES_IMAGE, path);
+    if (slot >= 0)
+        return Share(slot, scope);
+
+    slot = FreeSlot();
+    if (slot < 0)
+        return RES_INVALID;
+
+    Image img = LoadImage(path);
+    if (img.data == NULL)
+        return RES_INVALID;
+
+    entries[slot].as.image = img;
+    return Commit(slot, RES_IMAGE, scope, path,
+                  (size_t)GetPixelDataSize(img.width, img.height, img.format));
+}
+
+ResourceHandle ResLoadTexture(const char *path, ResourceScope scope)
+{
+    int slot = FindSlot(RES_TEXTURE, path);
+    if (slot >= 0)
+        return Share(slot, scope);
+
+    slot = FreeSlot();
+    if (slot < 0)
+        return RES_INVALID;
+
+    Texture2D tex = LoadTexture(path);
+    if (tex.id == 0)
+        return RES_INVALID;
+
+    entries[slot].as.texture = tex;
+    return Commit(slot, RES_TEXTURE, scope, path,
+                  (size_t)GetPixelDataSize(tex.width, tex.height, tex.format));
+}
+
+// Upload an image that is already registered. The source image is never
+// modified; rotation happens on a temporary copy.
+ResourceHandle ResLoadTextureFromImage(ResourceHandle image, int rotateCW, ResourceScope scope)
+{
+    ResourceEntry *src = Lookup(image);
+    if (src == NULL || src->kind != RES_IMAGE)
+        return RES_INVALID;
+
+    char key[RES_MAX_PATH + 4];
+    snprintf(key, sizeof(key), "%s%s", src->key, rotateCW ? "|cw" : "");
+
+    int slot = FindSlot(RES_TEXTURE, key);
+    if (slot >= 0)
+        return Share(slot, scope);
+
+    slot = FreeSlot();
+    if (slot < 0)
+        return RES_INVALID;
+
+    Texture2D tex;
+    if (rotateCW)
+    {
+        Image temp = ImageCopy(src->as.image);
+        ImageRotateCW(&temp);
+        tex = LoadTextureFromImage(temp);
+        UnloadImage(temp);
+    }
+    else
+    {
+        tex = LoadTextureFromImage(src->as.image);
+    }
+    if (tex.id == 0)
+        return RES_INVALID;
+
+    entries[slot].as.texture = tex;
+    return Commit(slot, RES_TEXTURE, scope, key,
+                  (size_t)GetPixelDataSize(tex.width, tex.height, tex.format));
+}
+
+ResourceHandle ResLoadMusic(const char *path, ResourceScope scope)
+{
+    int slot = FindSlot(RES_MUSIC, path);
+    if (slot >= 0)
+        return Share(slot, scope);
+
+    slot = FreeSlot();
+    if (slot < 0)
+        return RES_INVALID;
+
+    Music music = LoadMusicStream(path);
+    if (music.stream.buffer == NULL)
+        return RES_INVALID;
+
+    entries[slot].as.music = music;
+    size_t frameBytes = (size_t)music.stream.channels * (music.stream.sampleSize / 8);
+    return Commit(slot, RES_MUSIC, scope, path, 2 * RES_MUSIC_SUBBUFFER_FRAMES * frameBytes);
+}
+
+void ResAcquire(ResourceHandle h)
+{
+    ResourceEntry *e = Lookup(h);
+    if (e != NULL)
+        e->refs++;
+}
+
+void ResRelease(ResourceHandle h)
+{
+    ResourceEntry *e = Lookup(h);
+    if (e == NULL)
+        return;
+    if (--e->refs <= 0)
+        Unload(e);
+}
+
+// Drop everything owned by a scope, whatever its reference count.
+void ResReleaseScope(ResourceScope scope)
+{
+    for (int i = 0; i < RES_MAX_ENTRIES; i++)
+    {
+        ResourceEntry *e = &entries[i];
+        if (!e->used || e->scope != scope)
+            continue;
+        if (e->refs > 1)
+            TraceLog(LOG_DEBUG, "RES: %s still has %d references at %s scope exit",
+                     e->key, e->refs, scopeNames[scope]);
+        Unload(e);
+    }
+}
+
+int ResIsValid(ResourceHandle h)
+{
+    return Lookup(h) != NULL;
+}
+
+Image ResGetImage(ResourceHandle h)
+{
+    ResourceEntry *e = Lookup(h);
+    if (e == NULL || e->kind != RES_IMAGE)
+        return (Image){0};
+    return e->as.image;
+}
+
+Texture2D ResGetTexture(ResourceHandle h)
+{
+    ResourceEntry *e = Lookup(h);
+    if (e == NULL || e->kind != RES_TEXTURE)
+        return (Texture2D){0};
+    return e->as.texture;
+}
+
+Music ResGetMusic(ResourceHandle h)
+{
+    ResourceEntry *e = Lookup(h);
+    if (e == NULL || e->kind != RES_MUSIC)
+        return (Music){0};
+    return e->as.music;
+}
+
+void ResGetReport(ResourceReport *out)
+{
+    *out = report;
+}
+
+int ResIsOverBudget(void)
+{
+    return report.budgetBytes > 0 && report.totalBytes > report.budgetBytes;
+}
+
+// Debug overlay: bytes held per kind and per scope
+void ResDrawReport(int x, int y)
+{
+    DrawRectangle(x - 5, y - 5, 260, 150, Fade(BLACK, 0.7f));
+    DrawText(TextFormat("RAM/VRAM: %zu KB (peak %zu KB)", report.totalBytes / 1024, report.peakBytes / 1024),
+             x, y, 10, ResIsOverBudget() ? RED : WHITE);
+    y += 16;
+    if (report.budgetBytes > 0)
+    {
+        DrawText(TextFormat("Budget: %zu KB", report.budgetBytes / 1024), x, y, 10, WHITE);
+        y += 16;
+    }
+    for (int k = 0; k < RES_KIND_COUNT; k++, y += 14)
+        DrawText(TextFormat("%-8s %3d  %8zu KB", kindNames[k], report.kindCount[k], report.kindBytes[k] / 1024),
+                 x, y, 10, LIGHTGRAY);
+    for (int s = 0; s < SCOPE_COUNT; s++, y += 14)
+        DrawText(TextFormat("scope %-6s %8zu KB", scopeNames[s], report.scopeBytes[s] / 1024), x, y, 10, GRAY);
+}
@@ -0,0 +1,70 @@
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include "raylib.h"
+#include <stddef.h>
+
+// Central registry for every Image, Texture2D and Music the game loads.
+// Callers hold small handles instead of the raylib structs, loads of the same
+// file are shared through a reference count, and each resource belongs to a
+// scope that can be released in one call when that scope ends.
+
+#define RES_MAX_ENTRIES 256
+#define RES_MAX_PATH 128
+
+typedef enum
+{
+    RES_IMAGE,   // CPU pixels
+    RES_TEXTURE, // GPU pixels
+    RES_MUSIC,   // Streaming audio buffers
+    RES_KIND_COUNT
+} ResourceKind;
+
+typedef enum
+{
+    SCOPE_GLOBAL, // Lives until ResShutdown
+    SCOPE_MATCH,  // Released when a match ends
+    SCOPE_SCREEN, // Released when the current screen changes
+    SCOPE_COUNT
+} ResourceScope;
+
+// Low 16 bits: slot + 1, high 16 bits: slot generation. 0 is never valid.
+typedef struct
+{
+    unsigned int id;
+} ResourceHandle;
+
+#define RES_INVALID ((ResourceHandle){0})
+
+typedef struct
+{
+    size_t kindBytes[RES_KIND_COUNT];
+    size_t scopeBytes[SCOPE_COUNT];
+    int kindCount[RES_KIND_COUNT];
+    size_t totalBytes;
+    size_t peakBytes;
+    size_t budgetBytes; // 0 = no ceiling
+} ResourceReport;
+
+void ResInit(size_t budgetBytes);
+void ResShutdown(void);
+
+ResourceHandle ResLoadImage(const char *path, ResourceScope scope);
+ResourceHandle ResLoadTexture(const char *path, ResourceScope scope);
+ResourceHandle ResLoadTextureFromImage(ResourceHandle image, int rotateCW, ResourceScope scope);
+ResourceHandle ResLoadMusic(const char *path, ResourceScope scope);
+
+void ResAcquire(ResourceHandle h);
+void ResRelease(ResourceHandle h);
+void ResReleaseScope(ResourceScope scope);
+int ResIsValid(ResourceHandle h);
+
+Image ResGetImage(ResourceHandle h);
+Texture2D ResGetTexture(ResourceHandle h);
+Music ResGetMusic(ResourceHandle h);
+
+void ResGetReport(ResourceReport *report);
+int ResIsOverBudget(void);
+void ResDrawReport(int x, int y);
+
+#endif
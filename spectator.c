@@ -0,0 +1,172 @@
+/*******************************************************************************************
+*
+*   GOWTHER spectator (Linux/macOS)
+*
+*   Watches a live match on a match server with the game's own board drawing.
+*   The server sends a keyframe of the match view, then deltas; in between the
+*   carousel and clocks are moved forward locally. When the match ends the
+*   client waits a few seconds and watches whatever is live next.
+*
+*   Usage: spectator [host] [port] [matchId]   (matchId 0 or omitted = any)
+*
+********************************************************************************************/
+
+#include "raylib.h"
+#include "resources.h"
+#include "matchview.h"
+#include "boardview.h"
+#include "netproto.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MEMORY_BUDGET (128 * 1024 * 1024)
+#define RETRY_DELAY 1.0 // After "no such match"
+#define NEXT_MATCH_DELAY 5.0
+#define IN_BUF 1024
+
+static void SendSpectate(int fd, unsigned int matchId)
+{
+    unsigned char msg[NET_HEADER + 4] = {MSG_SPECTATE, 4};
+    NetPutU32(msg + NET_HEADER, matchId);
+    send(fd, msg, sizeof(msg), MSG_NOSIGNAL);
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? atoi(argv[2]) : NET_DEFAULT_PORT;
+    unsigned int matchId = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 0) : 0;
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        TraceLog(LOG_ERROR, "SPECTATOR: Could not connect to %s:%d", host, port);
+        return 1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    InitWindow(VIEW_WIDTH, VIEW_HEIGHT, "GOWTHER - spectator");
+    ResInit(MEMORY_BUDGET);
+    BoardArt art;
+    BoardArtLoad(&art);
+    SetTargetFPS(60);
+
+    MatchView view;      // Exactly what the server has sent
+    double viewTime = 0; // When it was received
+    int hasView = 0;
+    int connected = 1;
+    double askAt = GetTime();
+    double start = GetTime();
+    long long received = 0;
+    char result[64] = "";
+
+    unsigned char in[IN_BUF];
+    int inLen = 0;
+
+    while (!WindowShouldClose())
+    {
+        double now = GetTime();
+        if (connected && askAt > 0.0 && now >= askAt)
+        {
+            SendSpectate(fd, matchId);
+            askAt = 0.0;
+        }
+
+        // Network
+        while (connected)
+        {
+            ssize_t n = recv(fd, in + inLen, IN_BUF - inLen, 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+            {
+                connected = 0;
+                break;
+            }
+            if (n < 0)
+                break;
+            inLen += (int)n;
+            received += n;
+
+            int off = 0, len;
+            while ((len = NetFrameLength(in + off, inLen - off)) > 0)
+            {
+                const unsigned char *msg = in + off;
+                const unsigned char *p = msg + NET_HEADER;
+                switch (msg[0])
+                {
+                case MSG_KEYFRAME:
+                    hasView = MatchViewDecodeKeyframe(&view, p, msg[1]);
+                    viewTime = now;
+                    result[0] = '\0';
+                    break;
+                case MSG_DELTA:
+                    if (hasView && MatchViewDecodeDelta(&view, p, msg[1]))
+                        viewTime = now;
+                    break;
+                case MSG_REJECT:
+                    askAt = now + RETRY_DELAY;
+                    break;
+                case MSG_OVER:
+                {
+                    int winner = (signed char)p[4];
+                    if (winner < 0)
+                        TextCopy(result, TextFormat("Draw  %d - %d", NetGetU16(p), NetGetU16(p + 2)));
+                    else
+                        TextCopy(result, TextFormat("Seat %d wins  %d - %d", winner, NetGetU16(p), NetGetU16(p + 2)));
+                    view.over = 1;
+                    matchId = 0; // Whatever is live next
+                    askAt = now + NEXT_MATCH_DELAY;
+                    break;
+                }
+                default:
+                    break;
+                }
+                off += len;
+            }
+            memmove(in, in + off, inLen - off);
+            inLen -= off;
+        }
+
+        // Draw
+        BeginDrawing();
+        ClearBackground((Color){25, 25, 25, 255});
+
+        if (hasView)
+        {
+            MatchView shown = view;
+            MatchViewAdvance(&shown, (float)(now - viewTime));
+            DrawMatchView(&art, &shown);
+
+            int clock = (int)shown.matchElapsed;
+            DrawText(TextFormat("Match %08X  %02d:%02d  seat %d to play", shown.matchId, clock / 60, clock % 60, shown.turn),
+                     10, 10, 20, RAYWHITE);
+            if (result[0] != '\0')
+                DrawText(result, VIEW_WIDTH / 2 - MeasureText(result, 40) / 2, VIEW_HEIGHT / 2 - 20, 40, YELLOW);
+        }
+        else
+        {
+            const char *status = connected ? "Waiting for a live match..." : "Disconnected";
+            DrawText(status, VIEW_WIDTH / 2 - MeasureText(status, 30) / 2, VIEW_HEIGHT / 2 - 15, 30, RAYWHITE);
+        }
+        DrawText(TextFormat("%.0f B/s", received / (now - start + 1e-9)), 10, VIEW_HEIGHT - 20, 10, LIME);
+
+        EndDrawing();
+    }
+
+    close(fd);
+    ResShutdown();
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,557 @@
+#include "stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define STATS_MAX_PATH 256
+#define STATS_HASH_SLOTS (STATS_MAX_PLAYERS * 2)
+#define STATS_LOG_CHUNK (1024 * 1024) // Log file grows in steps of this many bytes
+
+typedef char StatsRecordIs64Bytes[sizeof(StatsRecord) == 64 ? 1 : -1];
+typedef char StatsProfileIs80Bytes[sizeof(StatsProfile) == 80 ? 1 : -1];
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int count; // Committed records
+    unsigned char pad[52];
+} StatsLogHeader; // 64 bytes, records follow
+
+// Newest record numbers of one type, oldest overwritten
+typedef struct
+{
+    unsigned int records[STATS_RECENT];
+    unsigned int count; // Ever added
+} StatsRecentRing;
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int applied;  // Log records folded in
+    unsigned int applying; // Record being folded in + 1; non-zero after a crash mid-update
+    unsigned int playerCount;
+    unsigned int matchCount;
+    unsigned int lastMatch; // Newest match record + 1
+    unsigned int leaderCount;
+    StatsRecentRing recentMatches;
+    StatsRecentRing recentSessions;
+    unsigned short leaders[STATS_LEADERS];
+    unsigned short nameHash[STATS_HASH_SLOTS]; // Player + 1, 0 = empty
+    StatsCard cards[CARD_DEF_COUNT];
+    StatsProfile profiles[STATS_MAX_PLAYERS];
+} StatsIndex;
+
+//----------------------------------------------------------------------------------
+// Mapped files
+//----------------------------------------------------------------------------------
+typedef struct
+{
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    unsigned char *base;
+    size_t size;
+} MappedFile;
+
+#if defined(_WIN32)
+
+static int MapResize(MappedFile *m, size_t size)
+{
+    if (m->base != NULL)
+        UnmapViewOfFile(m->base);
+    if (m->mapping != NULL)
+        CloseHandle(m->mapping);
+    m->base = NULL;
+    m->mapping = CreateFileMappingA(m->file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32),
+                                    (DWORD)size, NULL);
+    if (m->mapping == NULL)
+        return 0;
+    m->base = MapViewOfFile(m->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    m->size = size;
+    return m->base != NULL;
+}
+
+static int MapOpen(MappedFile *m, const char *path, size_t minSize)
+{
+    memset(m, 0, sizeof(*m));
+    m->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+                          FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m->file == INVALID_HANDLE_VALUE)
+        return 0;
+    LARGE_INTEGER size;
+    GetFileSizeEx(m->file, &size);
+    // Mapping a larger size than the file extends it, zero-filled
+    return MapResize(m, (size_t)size.QuadPart > minSize ? (size_t)size.QuadPart : minSize);
+}
+
+static void MapSync(MappedFile *m)
+{
+    FlushViewOfFile(m->base, m->size);
+    FlushFileBuffers(m->file);
+}
+
+static void MapClose(MappedFile *m)
+{
+    if (m->base != NULL)
+        UnmapViewOfFile(m->base);
+    if (m->mapping != NULL)
+        CloseHandle(m->mapping);
+    if (m->file != INVALID_HANDLE_VALUE && m->file != NULL)
+        CloseHandle(m->file);
+    memset(m, 0, sizeof(*m));
+}
+
+#else
+
+static int MapResize(MappedFile *m, size_t size)
+{
+    if (m->base != NULL)
+        munmap(m->base, m->size);
+    m->base = NULL;
+    if (ftruncate(m->fd, (off_t)size) != 0)
+        return 0;
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+    if (p == MAP_FAILED)
+        return 0;
+    m->base = p;
+    m->size = size;
+    return 1;
+}
+
+static int MapOpen(MappedFile *m, const char *path, size_t minSize)
+{
+    memset(m, 0, sizeof(*m));
+    m->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (m->fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(m->fd, &st) != 0)
+        return 0;
+    return MapResize(m, (size_t)st.st_size > minSize ? (size_t)st.st_size : minSize);
+}
+
+static void MapSync(MappedFile *m)
+{
+    msync(m->base, m->size, MS_SYNC);
+}
+
+static void MapClose(MappedFile *m)
+{
+    if (m->base != NULL)
+        munmap(m->base, m->size);
+    if (m->fd >= 0)
+        close(m->fd);
+    memset(m, 0, sizeof(*m));
+    m->fd = -1;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------
+// Store
+//----------------------------------------------------------------------------------
+static MappedFile logFile;
+static MappedFile indexFile;
+static int open_ = 0;
+
+static StatsLogHeader *LogHeader(void)
+{
+    return (StatsLogHeader *)logFile.base;
+}
+
+static StatsRecord *LogRecord(unsigned int i)
+{
+    return (StatsRecord *)(logFile.base + sizeof(StatsLogHeader)) + i;
+}
+
+static StatsIndex *Index(void)
+{
+    return (StatsIndex *)indexFile.base;
+}
+
+static unsigned int Checksum(const StatsRecord *r)
+{
+    const unsigned char *p = (const unsigned char *)r + sizeof(r->checksum);
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < sizeof(*r) - sizeof(r->checksum); i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static unsigned int NameHash(const char *name)
+{
+    unsigned int h = 2166136261u;
+    for (; *name; name++)
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
+}
+
+static int FindPlayer(const char *name)
+{
+    StatsIndex *ix = Index();
+    for (unsigned int i = NameHash(name);; i++)
+    {
+        unsigned short slot = ix->nameHash[i % STATS_HASH_SLOTS];
+        if (slot == 0)
+            return -1;
+        if (strcmp(ix->profiles[slot - 1].name, name) == 0)
+            return slot - 1;
+    }
+}
+
+// Leaderboard order: most wins, then most points
+static int Ahead(const StatsProfile *a, const StatsProfile *b)
+{
+    if (a->wins != b->wins)
+        return a->wins > b->wins;
+    return a->totalScore > b->totalScore;
+}
+
+// Move a player whose record just improved into place on the leaderboard
+static void UpdateLeaders(StatsIndex *ix, int player)
+{
+    int pos = -1;
+    for (unsigned int i = 0; i < ix->leaderCount; i++)
+    {
+        if (ix->leaders[i] == player)
+            pos = (int)i;
+    }
+    if (pos < 0)
+    {
+        if (ix->leaderCount < STATS_LEADERS)
+            pos = (int)ix->leaderCount++;
+        else if (Ahead(&ix->profiles[player], &ix->profiles[ix->leaders[STATS_LEADERS - 1]]))
+            pos = STATS_LEADERS - 1;
+        else
+            return;
+        ix->leaders[pos] = (unsigned short)player;
+    }
+    while (pos > 0 && Ahead(&ix->profiles[player], &ix->profiles[ix->leaders[pos - 1]]))
+    {
+        ix->leaders[pos] = ix->leaders[pos - 1];
+        ix->leaders[--pos] = (unsigned short)player;
+    }
+}
+
+static void PushRecent(StatsRecentRing *ring, unsigned int record)
+{
+    ring->records[ring->count % STATS_RECENT] = record;
+    ring->count++;
+}
+
+// Fold record i into the index. Bracketed by `applying` so a crash halfway
+// through is detected on the next open.
+static void Apply(unsigned int i)
+{
+    StatsIndex *ix = Index();
+    const StatsRecord *r = LogRecord(i);
+    ix->applying = i + 1;
+
+    if (r->type == STATS_REC_PLAYER && ix->playerCount < STATS_MAX_PLAYERS)
+    {
+        int player = (int)ix->playerCount++;
+        StatsProfile *p = &ix->profiles[player];
+        memset(p, 0, sizeof(*p));
+        memcpy(p->name, r->as.name, STATS_NAME_MAX);
+        p->name[STATS_NAME_MAX - 1] = '\0';
+        unsigned int slot = NameHash(p->name);
+        while (ix->nameHash[slot % STATS_HASH_SLOTS] != 0)
+            slot++;
+        ix->nameHash[slot % STATS_HASH_SLOTS] = (unsigned short)(player + 1);
+    }
+    else if (r->type == STATS_REC_MATCH)
+    {
+        for (int s = 0; s < 2; s++)
+        {
+            int player = r->as.match.players[s];
+            if (player >= (int)ix->playerCount)
+                continue;
+            StatsProfile *p = &ix->profiles[player];
+            p->matches++;
+            if (r->winner == s + 1)
+                p->wins++;
+            else if (r->winner == 0)
+                p->draws++;
+            p->totalScore += r->as.match.totals[s];
+            if (r->as.match.totals[s] > p->best)
+                p->best = r->as.match.totals[s];
+            p->lastMatch = i + 1;
+            UpdateLeaders(ix, player);
+
+            for (int d = 0; d < CARD_DEF_COUNT; d++)
+            {
+                ix->cards[d].picks += r->as.match.picks[s][d];
+                ix->cards[d].matchPicks += r->as.match.picks[s][d];
+                if (r->winner == s + 1)
+                    ix->cards[d].wins += r->as.match.picks[s][d];
+            }
+        }
+        ix->matchCount++;
+        ix->lastMatch = i + 1;
+        PushRecent(&ix->recentMatches, i);
+    }
+    else if (r->type == STATS_REC_SESSION && r->as.match.players[0] < ix->playerCount)
+    {
+        StatsProfile *p = &ix->profiles[r->as.match.players[0]];
+        p->sessions++;
+        p->sessionScore += r->as.match.totals[0];
+        if (r->as.match.totals[0] > p->sessionBest)
+            p->sessionBest = r->as.match.totals[0];
+        for (int d = 0; d < CARD_DEF_COUNT; d++)
+            ix->cards[d].picks += r->as.match.picks[0][d];
+        PushRecent(&ix->recentSessions, i);
+    }
+
+    ix->applied = i + 1;
+    ix->applying = 0;
+}
+
+static void ResetIndex(void)
+{
+    StatsIndex *ix = Index();
+    memset(ix, 0, sizeof(*ix));
+    memcpy(ix->magic, STATS_MAGIC_INDEX, 4);
+    ix->version = STATS_INDEX_VERSION;
+}
+
+static int Append(const StatsRecord *r)
+{
+    StatsLogHeader *h = LogHeader();
+    size_t need = sizeof(StatsLogHeader) + ((size_t)h->count + 1) * sizeof(StatsRecord);
+    if (need > logFile.size)
+    {
+        if (!MapResize(&logFile, logFile.size + STATS_LOG_CHUNK))
+            return -1;
+        h = LogHeader();
+    }
+
+    unsigned int i = h->count;
+    StatsRecord *slot = LogRecord(i);
+    *slot = *r;
+    slot->checksum = Checksum(slot);
+    // Commit point: the record exists once the count covers it
+    __atomic_store_n(&h->count, i + 1, __ATOMIC_RELEASE);
+    Apply(i);
+    return (int)i;
+}
+
+int StatsOpen(const char *prefix)
+{
+    char path[STATS_MAX_PATH];
+    if (open_)
+        return 1;
+
+    snprintf(path, sizeof(path), "%s.log", prefix);
+    if (!MapOpen(&logFile, path, STATS_LOG_CHUNK))
+    {
+        MapClose(&logFile);
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s.idx", prefix);
+    if (!MapOpen(&indexFile, path, sizeof(StatsIndex)))
+    {
+        MapClose(&logFile);
+        MapClose(&indexFile);
+        return 0;
+    }
+
+    StatsLogHeader *h = LogHeader();
+    if (memcmp(h->magic, STATS_MAGIC_LOG, 4) != 0 || h->version != STATS_VERSION)
+    {
+        memset(h, 0, sizeof(*h));
+        memcpy(h->magic, STATS_MAGIC_LOG, 4);
+        h->version = STATS_VERSION;
+    }
+    size_t capacity = (logFile.size - sizeof(StatsLogHeader)) / sizeof(StatsRecord);
+    if (h->count > capacity)
+        h->count = (unsigned int)capacity;
+
+    // Rebuild from the whole log only if the index is missing, from another
+    // version, ahead of the log or was interrupted mid-update
+    StatsIndex *ix = Index();
+    if (memcmp(ix->magic, STATS_MAGIC_INDEX, 4) != 0 || ix->version != STATS_INDEX_VERSION || ix->applying != 0 ||
+        ix->applied > h->count)
+        ResetIndex();
+
+    // Catch up on committed records the index has not seen. A record that
+    // fails its checksum (torn by a crash) ends the log there.
+    for (unsigned int i = ix->applied; i < h->count; i++)
+    {
+        if (LogRecord(i)->checksum != Checksum(LogRecord(i)))
+        {
+            h->count = i;
+            break;
+        }
+        Apply(i);
+    }
+
+    open_ = 1;
+    return 1;
+}
+
+void StatsSync(void)
+{
+    if (!open_)
+        return;
+    MapSync(&logFile);
+    MapSync(&indexFile);
+}
+
+void StatsClose(void)
+{
+    if (!open_)
+        return;
+    StatsSync();
+    MapClose(&logFile);
+    MapClose(&indexFile);
+    open_ = 0;
+}
+
+// Id of the named player, created on first use. -1 if the store is closed or full.
+int StatsPlayer(const char *name)
+{
+    if (!open_)
+        return -1;
+    int player = FindPlayer(name);
+    if (player >= 0)
+        return player;
+    if (Index()->playerCount >= STATS_MAX_PLAYERS)
+        return -1;
+
+    StatsRecord r;
+    memset(&r, 0, sizeof(r));
+    r.type = STATS_REC_PLAYER;
+    r.time = (unsigned int)time(NULL);
+    snprintf(r.as.name, sizeof(r.as.name), "%s", name);
+    if (Append(&r) < 0)
+        return -1;
+    return (int)Index()->playerCount - 1;
+}
+
+static unsigned short ClampDuration(int duration)
+{
+    return (unsigned short)(duration < 0 ? 0 : duration > 0xFFFF ? 0xFFFF : duration);
+}
+
+// Returns the record number of the match, or -1. Both seats must be known
+// players: anything less is a session.
+int StatsRecordMatch(const StatsMatchResult *result)
+{
+    if (!open_ || StatsGetProfile(result->players[0]) == NULL || StatsGetProfile(result->players[1]) == NULL ||
+        result->players[0] == result->players[1])
+        return -1;
+
+    StatsRecord r;
+    memset(&r, 0, sizeof(r));
+    r.type = STATS_REC_MATCH;
+    r.winner = (unsigned char)(result->winner + 1);
+    r.duration = ClampDuration(result->duration);
+    r.time = (unsigned int)time(NULL);
+    for (int s = 0; s < 2; s++)
+    {
+        const StatsProfile *p = StatsGetProfile(result->players[s]);
+        r.as.match.players[s] = (unsigned short)result->players[s];
+        r.as.match.totals[s] = (unsigned short)(result->totals[s] < 0 ? 0 : result->totals[s]);
+        r.as.match.prev[s] = p != NULL ? p->lastMatch : 0;
+    }
+    memcpy(r.as.match.picks, result->picks, sizeof(r.as.match.picks));
+    return Append(&r);
+}
+
+// Returns the record number of the session, or -1
+int StatsRecordSession(const StatsSessionResult *result)
+{
+    if (!open_ || StatsGetProfile(result->player) == NULL)
+        return -1;
+
+    StatsRecord r;
+    memset(&r, 0, sizeof(r));
+    r.type = STATS_REC_SESSION;
+    r.duration = ClampDuration(result->duration);
+    r.time = (unsigned int)time(NULL);
+    r.as.match.players[0] = (unsigned short)result->player;
+    r.as.match.players[1] = 0xFFFF;
+    r.as.match.totals[0] = (unsigned short)(result->total < 0 ? 0 : result->total);
+    memcpy(r.as.match.picks[0], result->picks, sizeof(r.as.match.picks[0]));
+    return Append(&r);
+}
+
+const StatsProfile *StatsGetProfile(int player)
+{
+    if (!open_ || player < 0 || player >= (int)Index()->playerCount)
+        return NULL;
+    return &Index()->profiles[player];
+}
+
+int StatsLeaderboard(const StatsProfile **out, int max)
+{
+    if (!open_)
+        return 0;
+    StatsIndex *ix = Index();
+    int n = 0;
+    for (; n < max && n < (int)ix->leaderCount; n++)
+        out[n] = &ix->profiles[ix->leaders[n]];
+    return n;
+}
+
+const StatsCard *StatsCardStats(int defId)
+{
+    if (!open_ || defId < 0 || defId >= CARD_DEF_COUNT)
+        return NULL;
+    return &Index()->cards[defId];
+}
+
+unsigned int StatsMatchCount(void)
+{
+    return open_ ? Index()->matchCount : 0;
+}
+
+// Newest first, at most STATS_RECENT
+static int ReadRecent(const StatsRecentRing *ring, const StatsRecord **out, int max)
+{
+    int n = 0;
+    for (; n < max && n < STATS_RECENT && (unsigned int)n < ring->count; n++)
+        out[n] = LogRecord(ring->records[(ring->count - 1 - n) % STATS_RECENT]);
+    return n;
+}
+
+int StatsRecentMatches(const StatsRecord **out, int max)
+{
+    return open_ ? ReadRecent(&Index()->recentMatches, out, max) : 0;
+}
+
+int StatsRecentSessions(const StatsRecord **out, int max)
+{
+    return open_ ? ReadRecent(&Index()->recentSessions, out, max) : 0;
+}
+
+// Newest first, following the player's chain of previous matches
+int StatsPlayerMatches(int player, const StatsRecord **out, int max)
+{
+    const StatsProfile *p = StatsGetProfile(player);
+    if (p == NULL)
+        return 0;
+    int n = 0;
+    for (unsigned int next = p->lastMatch; next != 0 && n < max;)
+    {
+        const StatsRecord *r = LogRecord(next - 1);
+        out[n++] = r;
+        next = r->as.match.players[0] == player ? r->as.match.prev[0] : r->as.match.prev[1];
+    }
+    return n;
+}
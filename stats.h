@@ -0,0 +1,113 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "cards.h"
+
+// Local player stats and match history. Every change is a fixed-size record
+// appended to a memory-mapped log (prefix.log); aggregates - profiles,
+// per-card counts, the leaderboard - live in a memory-mapped index
+// (prefix.idx) that is updated as records are committed, so opening the
+// store only replays records the index has not seen yet. The index also keeps
+// the newest match and session record numbers, so history queries never
+// scan the log.
+//
+// A record counts once the log's record count is bumped, so a process crash
+// loses at most the record being written. StatsSync flushes both files to
+// disk for protection against power loss as well.
+//
+// Pointers returned below point into the mapped files and stay valid until
+// the next StatsPlayer or StatsRecordMatch call.
+
+#define STATS_MAGIC_LOG "GWSL"
+#define STATS_MAGIC_INDEX "GWSI"
+#define STATS_VERSION 1       // Log format
+#define STATS_INDEX_VERSION 2 // Index layout; a mismatch rebuilds the index from the log
+#define STATS_NAME_MAX 32
+#define STATS_MAX_PLAYERS 1024
+#define STATS_LEADERS 10
+#define STATS_RECENT 32 // Newest matches and sessions the index keeps
+
+typedef enum
+{
+    STATS_REC_PLAYER = 1,
+    STATS_REC_MATCH,
+    STATS_REC_SESSION // Single-seat play: counted per player, kept out of the leaderboard and card win rates
+} StatsRecordType;
+
+typedef struct
+{
+    unsigned int checksum; // FNV-1a of the 60 bytes that follow
+    unsigned char type;    // StatsRecordType
+    unsigned char winner;  // Seat + 1, 0 for a draw
+    unsigned short duration; // Seconds
+    unsigned int time;     // Unix time
+    union
+    {
+        struct
+        {
+            unsigned short players[2];
+            unsigned short totals[2];
+            unsigned int prev[2]; // Each player's previous match record + 1, 0 if none
+            unsigned char picks[2][CARD_DEF_COUNT];
+        } match; // Sessions use seat 0 only
+        char name[STATS_NAME_MAX];
+    } as;
+    unsigned char pad[12];
+} StatsRecord; // 64 bytes
+
+typedef struct
+{
+    char name[STATS_NAME_MAX];
+    unsigned int matches;
+    unsigned int wins;
+    unsigned int draws;
+    unsigned int best; // Highest total in one match
+    unsigned long long totalScore;
+    unsigned int lastMatch; // Newest match record + 1, 0 if none
+    unsigned int sessions;  // Single-seat sessions, not in the counts above
+    unsigned int sessionBest;
+    unsigned int pad;
+    unsigned long long sessionScore;
+} StatsProfile; // 80 bytes
+
+typedef struct
+{
+    unsigned long long picks;      // In matches and sessions
+    unsigned long long matchPicks; // In matches only
+    unsigned long long wins;       // Match picks by the side that went on to win
+} StatsCard;
+
+typedef struct
+{
+    int players[2]; // From StatsPlayer
+    int totals[2];
+    int winner; // Seat, -1 for a draw
+    int duration;
+    unsigned char picks[2][CARD_DEF_COUNT];
+} StatsMatchResult;
+
+typedef struct
+{
+    int player;
+    int total;
+    int duration;
+    unsigned char picks[CARD_DEF_COUNT];
+} StatsSessionResult;
+
+int StatsOpen(const char *prefix);
+void StatsClose(void);
+void StatsSync(void);
+
+int StatsPlayer(const char *name);
+int StatsRecordMatch(const StatsMatchResult *result);
+int StatsRecordSession(const StatsSessionResult *result);
+
+const StatsProfile *StatsGetProfile(int player);
+int StatsLeaderboard(const StatsProfile **out, int max);
+const StatsCard *StatsCardStats(int defId);
+unsigned int StatsMatchCount(void);
+int StatsRecentMatches(const StatsRecord **out, int max);
+int StatsRecentSessions(const StatsRecord **out, int max);
+int StatsPlayerMatches(int player, const StatsRecord **out, int max);
+
+#endif
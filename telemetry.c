@@ -0,0 +1,331 @@
+#define _POSIX_C_SOURCE 200809L
+#include "telemetry.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TELEMETRY_BLOCK_BYTES (64 * 1024)
+#define TELEMETRY_MAX_ENCODED 32 // Worst case bytes for one encoded event
+#define TELEMETRY_MAX_PATH 256
+
+// Single producer (the owning thread), single consumer (the writer).
+// head and tail sit on separate cache lines so the two never contend.
+typedef struct
+{
+    TelemetryEvent events[TELEMETRY_RING_SIZE];
+    unsigned int head;
+    char pad0[60];
+    unsigned int tail;
+    char pad1[60];
+    unsigned long long dropped;
+} TelemetryRing;
+
+// Rings live for the whole process: a thread may still hold its pointer
+// after a stop/start cycle
+static TelemetryRing *rings[TELEMETRY_MAX_THREADS];
+static int ringCount = 0;
+static int running = 0;
+static __thread TelemetryRing *threadRing = NULL;
+static __thread int threadRingFull = 0;
+
+static pthread_t writer;
+static char prefix[TELEMETRY_MAX_PATH];
+static FILE *file = NULL;
+static int fileIndex = 0;
+static long fileBytes = 0;
+static unsigned char block[TELEMETRY_BLOCK_BYTES];
+
+static unsigned long long NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static TelemetryRing *RegisterThread(void)
+{
+    if (threadRingFull)
+        return NULL;
+
+    int index = __atomic_fetch_add(&ringCount, 1, __ATOMIC_ACQ_REL);
+    if (index >= TELEMETRY_MAX_THREADS)
+    {
+        threadRingFull = 1;
+        return NULL;
+    }
+
+    TelemetryRing *r = calloc(1, sizeof(TelemetryRing));
+    if (r == NULL)
+    {
+        threadRingFull = 1;
+        return NULL;
+    }
+    for (int i = 0; i < TELEMETRY_RING_SIZE; i++)
+        r->events[i].thread = (unsigned char)index;
+    __atomic_store_n(&rings[index], r, __ATOMIC_RELEASE);
+    threadRing = r;
+    return r;
+}
+
+void TelemetryRecord(int type, unsigned int arg0, unsigned int arg1, unsigned int arg2, float value)
+{
+    if (!__atomic_load_n(&running, __ATOMIC_RELAXED))
+        return;
+
+    TelemetryRing *r = threadRing;
+    if (r == NULL && (r = RegisterThread()) == NULL)
+        return;
+
+    unsigned int head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= TELEMETRY_RING_SIZE)
+    {
+        // Writer fell behind; losing an event beats stalling the frame
+        __atomic_add_fetch(&r->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    TelemetryEvent *e = &r->events[head & (TELEMETRY_RING_SIZE - 1)];
+    e->time = NowNs();
+    e->type = (unsigned char)type;
+    e->arg0 = (unsigned short)arg0;
+    e->arg1 = arg1;
+    e->arg2 = arg2;
+    e->value = value;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+unsigned long long TelemetryDropped(void)
+{
+    unsigned long long total = 0;
+    int count = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count && i < TELEMETRY_MAX_THREADS; i++)
+    {
+        TelemetryRing *r = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (r != NULL)
+            total += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+//----------------------------------------------------------------------------------
+// Writer
+//----------------------------------------------------------------------------------
+static void PutU32(unsigned char *p, unsigned int v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void PutU64(unsigned char *p, unsigned long long v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static int PutVarint(unsigned char *p, unsigned long long v)
+{
+    int n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+// Goes through the existing prefix_NNNN.gtl files, deleting those numbered
+// up to `removeUpTo`. Returns the highest number found, 0 if none.
+static int ScanFiles(int removeUpTo)
+{
+    char dir[TELEMETRY_MAX_PATH];
+    char path[TELEMETRY_MAX_PATH + 16];
+    const char *base = strrchr(prefix, '/');
+#if defined(_WIN32)
+    const char *backslash = strrchr(prefix, '\\');
+    if (backslash != NULL && (base == NULL || backslash > base))
+        base = backslash;
+#endif
+    if (base == NULL)
+    {
+        snprintf(dir, sizeof(dir), ".");
+        base = prefix;
+    }
+    else
+    {
+        snprintf(dir, sizeof(dir), "%.*s", base == prefix ? 1 : (int)(base - prefix), prefix);
+        base++;
+    }
+
+    DIR *d = opendir(dir);
+    if (d == NULL)
+        return 0;
+    size_t baseLen = strlen(base);
+    int highest = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        int index;
+        char ext[8];
+        if (strncmp(e->d_name, base, baseLen) != 0 || e->d_name[baseLen] != '_' ||
+            sscanf(e->d_name + baseLen + 1, "%d%7s", &index, ext) != 2 || strcmp(ext, ".gtl") != 0)
+            continue;
+        if (index > highest)
+            highest = index;
+        if (index <= removeUpTo)
+        {
+            snprintf(path, sizeof(path), "%s_%04d.gtl", prefix, index);
+            remove(path);
+        }
+    }
+    closedir(d);
+    return highest;
+}
+
+static int OpenNextFile(void)
+{
+    char path[TELEMETRY_MAX_PATH + 16];
+    if (file != NULL)
+        fclose(file);
+
+    fileIndex++;
+    snprintf(path, sizeof(path), "%s_%04d.gtl", prefix, fileIndex);
+    file = fopen(path, "wb");
+    if (file == NULL)
+        return 0;
+
+    unsigned char header[8];
+    memcpy(header, TELEMETRY_MAGIC, 4);
+    PutU32(header + 4, TELEMETRY_VERSION);
+    fwrite(header, 1, sizeof(header), file);
+    fileBytes = sizeof(header);
+
+    // Keep only the newest few files
+    if (fileIndex > TELEMETRY_KEEP_FILES)
+    {
+        snprintf(path, sizeof(path), "%s_%04d.gtl", prefix, fileIndex - TELEMETRY_KEEP_FILES);
+        remove(path);
+    }
+    return 1;
+}
+
+// Block: [bytes:u32][events:u32][baseTime:u64] then per event
+// zigzag-varint time delta, type (bit 7 = value present), thread,
+// varint arg0..arg2 and, if present, the raw 4-byte value.
+static void WriteBlock(int bytes, int events, unsigned long long baseTime)
+{
+    if (events == 0 || file == NULL)
+        return;
+    if (fileBytes + bytes + 16 > TELEMETRY_FILE_LIMIT && !OpenNextFile())
+        return;
+
+    unsigned char header[16];
+    PutU32(header, (unsigned int)bytes);
+    PutU32(header + 4, (unsigned int)events);
+    PutU64(header + 8, baseTime);
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(block, 1, bytes, file);
+    fileBytes += bytes + sizeof(header);
+}
+
+static void Drain(void)
+{
+    int bytes = 0, events = 0;
+    unsigned long long baseTime = 0, prevTime = 0;
+
+    int count = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count && i < TELEMETRY_MAX_THREADS; i++)
+    {
+        TelemetryRing *r = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (r == NULL)
+            continue;
+
+        unsigned int head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        unsigned int tail = r->tail;
+        for (; tail != head; tail++)
+        {
+            const TelemetryEvent *e = &r->events[tail & (TELEMETRY_RING_SIZE - 1)];
+            if (bytes + TELEMETRY_MAX_ENCODED > TELEMETRY_BLOCK_BYTES)
+            {
+                WriteBlock(bytes, events, baseTime);
+                bytes = events = 0;
+            }
+            if (events == 0)
+                baseTime = prevTime = e->time;
+
+            long long delta = (long long)(e->time - prevTime);
+            prevTime = e->time;
+            int hasValue = e->value != 0.0f;
+
+            bytes += PutVarint(block + bytes, ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63));
+            block[bytes++] = (unsigned char)(e->type | (hasValue ? 0x80 : 0));
+            block[bytes++] = e->thread;
+            bytes += PutVarint(block + bytes, e->arg0);
+            bytes += PutVarint(block + bytes, e->arg1);
+            bytes += PutVarint(block + bytes, e->arg2);
+            if (hasValue)
+            {
+                memcpy(block + bytes, &e->value, 4);
+                bytes += 4;
+            }
+            events++;
+        }
+        __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    WriteBlock(bytes, events, baseTime);
+    if (file != NULL)
+        fflush(file);
+}
+
+static void *WriterMain(void *arg)
+{
+    (void)arg;
+    struct timespec wait = {0, TELEMETRY_FLUSH_MS * 1000000L};
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+    {
+        nanosleep(&wait, NULL);
+        Drain();
+    }
+    Drain(); // Whatever was recorded before the stop
+    return NULL;
+}
+
+int TelemetryStart(const char *filePrefix)
+{
+    if (__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+        return 1;
+
+    snprintf(prefix, sizeof(prefix), "%s", filePrefix);
+    // Number on from an earlier session rather than overwrite part of it,
+    // then apply retention to everything on disk, not just this session
+    fileIndex = ScanFiles(0);
+    if (!OpenNextFile())
+        return 0;
+    ScanFiles(fileIndex - TELEMETRY_KEEP_FILES);
+
+    __atomic_store_n(&running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&writer, NULL, WriterMain, NULL) != 0)
+    {
+        __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+        fclose(file);
+        file = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void TelemetryStop(void)
+{
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+        return;
+
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    if (file != NULL)
+        fclose(file);
+    file = NULL;
+}
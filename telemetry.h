@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Gameplay telemetry. Recording copies one fixed-size event into a ring
+// buffer owned by the calling thread - no locks, no allocation, no I/O - and
+// a background thread drains every ring into compressed, size-rotated files.
+// telemetry_decode turns those files into CSV. When telemetry has not been
+// started TelemetryRecord returns immediately.
+//
+// Files are named prefix_NNNN.gtl. A new session numbers on from the highest
+// file already there, and only the newest TELEMETRY_KEEP_FILES are kept,
+// whichever session wrote them.
+
+#define TELEMETRY_RING_SIZE 4096 // Events per thread, power of two
+#define TELEMETRY_MAX_THREADS 64
+#define TELEMETRY_FILE_LIMIT (8 * 1024 * 1024) // Bytes before rotating
+#define TELEMETRY_KEEP_FILES 8
+#define TELEMETRY_FLUSH_MS 50
+#define TELEMETRY_MAGIC "GWTL"
+#define TELEMETRY_VERSION 1
+
+typedef enum
+{
+    TEL_CARD_PICK = 1, // arg0 def id, arg1 carousel head, arg2 reaction us, value offset px
+    TEL_ROW_PLACE,     // arg0 def id, arg1 row, arg2 power, value player
+    TEL_WEATHER,       // arg0 def id, arg1 weather bits after, value player
+    TEL_TURN_SWITCH,   // arg0 new seat, arg1 1 if it timed out
+    TEL_FRAME,         // value frame time ms
+    TEL_MATCH_END,     // arg0 total seat 0, arg1 total seat 1, arg2 winner + 1
+    TEL_RENDER,        // arg0 commands, arg1 texture switches, arg2 update us, value wait ms
+    TEL_TYPE_COUNT
+} TelemetryType;
+
+typedef struct
+{
+    unsigned long long time; // Nanoseconds, monotonic clock
+    unsigned char type;
+    unsigned char thread; // Ring index of the recording thread
+    unsigned short arg0;
+    unsigned int arg1;
+    unsigned int arg2;
+    float value;
+    unsigned int pad[2];
+} TelemetryEvent; // 32 bytes
+
+int TelemetryStart(const char *filePrefix);
+void TelemetryStop(void);
+void TelemetryRecord(int type, unsigned int arg0, unsigned int arg1, unsigned int arg2, float value);
+unsigned long long TelemetryDropped(void);
+
+#endif
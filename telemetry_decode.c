@@ -0,0 +1,128 @@
+/*******************************************************************************************
+*
+*   GOWTHER telemetry decoder
+*
+*   Turns the .gtl files written by telemetry.c into CSV on stdout, one row per
+*   event, with times in seconds from the first event of the first file.
+*
+*   Usage: telemetry_decode gowther_telemetry_0001.gtl [more.gtl ...] > events.csv
+*
+********************************************************************************************/
+
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *typeNames[TEL_TYPE_COUNT] = {
+    "unknown", "card_pick", "row_place", "weather", "turn_switch", "frame", "match_end", "render"};
+
+static unsigned int GetU32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long GetU64(const unsigned char *p)
+{
+    return GetU32(p) | ((unsigned long long)GetU32(p + 4) << 32);
+}
+
+static unsigned long long GetVarint(const unsigned char **p, const unsigned char *end)
+{
+    unsigned long long v = 0;
+    int shift = 0;
+    while (*p < end)
+    {
+        unsigned char b = *(*p)++;
+        v |= (unsigned long long)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            break;
+        shift += 7;
+    }
+    return v;
+}
+
+static int DecodeFile(const char *path, unsigned long long *origin)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 0;
+    }
+
+    unsigned char header[16];
+    if (fread(header, 1, 8, f) != 8 || memcmp(header, TELEMETRY_MAGIC, 4) != 0 ||
+        GetU32(header + 4) != TELEMETRY_VERSION)
+    {
+        fprintf(stderr, "%s: not a telemetry file\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    unsigned char *block = NULL;
+    unsigned int capacity = 0;
+    while (fread(header, 1, 16, f) == 16)
+    {
+        unsigned int bytes = GetU32(header);
+        unsigned int events = GetU32(header + 4);
+        unsigned long long time = GetU64(header + 8);
+        if (bytes > capacity)
+        {
+            capacity = bytes;
+            block = realloc(block, capacity);
+        }
+        if (fread(block, 1, bytes, f) != bytes)
+        {
+            fprintf(stderr, "%s: truncated block, stopping\n", path);
+            break;
+        }
+        if (*origin == 0)
+            *origin = time;
+
+        const unsigned char *p = block;
+        const unsigned char *end = block + bytes;
+        for (unsigned int i = 0; i < events && p < end; i++)
+        {
+            unsigned long long zz = GetVarint(&p, end);
+            time += (unsigned long long)((long long)(zz >> 1) ^ -(long long)(zz & 1));
+            if (end - p < 2)
+                break;
+            int type = *p & 0x7F;
+            int hasValue = *p++ & 0x80;
+            int thread = *p++;
+            unsigned long long arg0 = GetVarint(&p, end);
+            unsigned long long arg1 = GetVarint(&p, end);
+            unsigned long long arg2 = GetVarint(&p, end);
+            float value = 0.0f;
+            if (hasValue && end - p >= 4)
+            {
+                memcpy(&value, p, 4);
+                p += 4;
+            }
+
+            printf("%.9f,%d,%s,%llu,%llu,%llu,%g\n", (double)(long long)(time - *origin) * 1e-9, thread,
+                   type < TEL_TYPE_COUNT ? typeNames[type] : "unknown", arg0, arg1, arg2, value);
+        }
+    }
+
+    free(block);
+    fclose(f);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file.gtl [file.gtl ...]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned long long origin = 0;
+    int ok = 1;
+    printf("time_s,thread,type,arg0,arg1,arg2,value\n");
+    for (int i = 1; i < argc; i++)
+        ok &= DecodeFile(argv[i], &origin);
+    return ok ? 0 : 1;
+}
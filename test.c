@@ -33,28 +33,28 @@ int getColorIndex(Color c, Color colors[], int count) {
 }
 
 // Apply points according to rules
-void applyPoints(Card picked, int playerTurn, int *player1Points, int *player2Points, int blackShieldHolder)
+void applyPoints(const Card *picked, int playerTurn, int *player1Points, int *player2Points, int blackShieldHolder)
 {
     int shieldP1 = (blackShieldHolder == 1);
     int shieldP2 = (blackShieldHolder == 2);
 
-    if (CompareColor(picked.color, RED)) {
+    if (CompareColor(picked->color, RED)) {
         if (playerTurn == 1) *player2Points -= 5;
         else *player1Points -= 5;
     }
-    else if (CompareColor(picked.color, BLUE)) {
+    else if (CompareColor(picked->color, BLUE)) {
         if (playerTurn == 1) *player1Points += 15;
         else *player2Points += 15;
     }
-    else if (CompareColor(picked.color, ORANGE)) {
+    else if (CompareColor(picked->color, ORANGE)) {
         if (playerTurn == 1) *player1Points += 5;
         else *player2Points += 5;
     }
-    else if (CompareColor(picked.color, YELLOW)) {
+    else if (CompareColor(picked->color, YELLOW)) {
         if (playerTurn == 1) *player1Points += 10;
         else *player2Points += 10;
     }
-    else if (CompareColor(picked.color, GREEN)) {
+    else if (CompareColor(picked->color, GREEN)) {
         if (playerTurn == 1) {
             if (!shieldP1) *player1Points -= 3;
             if (!shieldP2) *player2Points -= 3;
@@ -83,6 +83,7 @@ int main(void)
     int player1Count[MAX_LINES] = {0};
     int player2Count[MAX_LINES] = {0};
 
+    int head = 0; // ring index of the top card, so scrolling never moves the cards
     float offsetY = 0.0f;
     float gameTimer = 0.0f;
     int playerTurn = 1;
@@ -106,11 +107,9 @@ int main(void)
         offsetY -= BASE_SPEED * dt;
         if (offsetY < -(CARD_HEIGHT + GAP)) {
             offsetY += (CARD_HEIGHT + GAP);
-            Card temp = cards[0];
-            for (int i = 0; i < MAX_CARDS - 1; i++)
-                cards[i] = cards[i + 1];
-            temp.color = mainColors[rand() % MAX_LINES];
-            cards[MAX_CARDS - 1] = temp;
+            // Recycle the top card as the new bottom card
+            cards[head].color = mainColors[rand() % MAX_LINES];
+            head = (head + 1) % MAX_CARDS;
         }
 
         // Find the nearest card to center for highlight
@@ -130,10 +129,10 @@ int main(void)
             else if (playerTurn == 2 && IsKeyPressed(KEY_ENTER)) pickPressed = 1;
 
             if (pickPressed) {
-                Card picked = cards[selectedIndex];
-                int colorIndex = getColorIndex(picked.color, mainColors, MAX_LINES);
+                const Card *picked = &cards[(head + selectedIndex) % MAX_CARDS];
+                int colorIndex = getColorIndex(picked->color, mainColors, MAX_LINES);
                 if (colorIndex != -1) {
-                    if (CompareColor(picked.color, BLACK))
+                    if (CompareColor(picked->color, BLACK))
                         blackShieldHolder = playerTurn;
 
                     if (playerTurn == 1 && player1Count[colorIndex] < MAX_BLOCKS * MAX_CARDS_PER_LINE)
@@ -166,7 +165,7 @@ int main(void)
             for (int i = 0; i < MAX_CARDS; i++) {
                 float x = GetScreenWidth() / 2 - CARD_WIDTH / 2;
                 float y = offsetY + i * (CARD_HEIGHT + GAP) + 50;
-                DrawRectangle(x, y, CARD_WIDTH, CARD_HEIGHT, cards[i].color);
+                DrawRectangle(x, y, CARD_WIDTH, CARD_HEIGHT, cards[(head + i) % MAX_CARDS].color);
                 if (i == selectedIndex)
                     DrawRectangleLinesEx((Rectangle){x, y, CARD_WIDTH, CARD_HEIGHT}, 5, BLACK); // shading effect
             }